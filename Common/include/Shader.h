@@ -7,6 +7,10 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
+#include <iterator>
+#include <cstdio>
 
 //GLAD
 #include <glad/glad.h>
@@ -14,12 +18,48 @@
 // GLFW
 #include <GLFW/glfw3.h>
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 using namespace std;
 
+// ARB_get_program_binary, core since GL 4.1: the GL 3.3 GLAD loader lacks it, so it is resolved through GLFW
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+// KHR_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+// Uniform location resolved once, so setting it needs neither a string lookup nor a driver query.
+// A location of -1 is ignored by glUniform*, like a name the program does not use.
+struct UniformHandle { GLint location = -1; };
+
+// Typed handles: getUniform() checks them against the reflected GLSL type
+struct IntUniform : UniformHandle { static bool accepts(GLenum type) { return type == GL_INT || type == GL_BOOL || type == GL_SAMPLER_2D || type == GL_SAMPLER_2D_ARRAY; } };
+struct FloatUniform : UniformHandle { static bool accepts(GLenum type) { return type == GL_FLOAT; } };
+struct Vec3Uniform : UniformHandle { static bool accepts(GLenum type) { return type == GL_FLOAT_VEC3; } };
+struct Vec4Uniform : UniformHandle { static bool accepts(GLenum type) { return type == GL_FLOAT_VEC4; } };
+struct Mat4Uniform : UniformHandle { static bool accepts(GLenum type) { return type == GL_FLOAT_MAT4; } };
+
 class Shader
 {
 public:
-	GLuint ID;
+	GLuint ID = 0;
+	Shader() {}
 	// Constructor generates the shader on the fly
 	Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
 	{
@@ -51,85 +91,353 @@ public:
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
+		compile(vertexCode, fragmentCode);
+		finish();
+	}
+
+	// Starts compiling and linking without waiting for the driver, so that several programs can be built
+	// side by side (see ShaderLibrary). finish() collects the result.
+	void compile(const std::string& vertexCode, const std::string& fragmentCode)
+	{
+		// Linked programs are cached per source and driver; a missing or rejected binary means a normal compile
+		linkedFromCache = false;
+		cacheFile.clear();
+		if (!cacheDirectory.empty() && loadBinaryFunctions()) {
+			cacheFile = cacheDirectory + "/" + getCacheKey(vertexCode, fragmentCode) + ".bin";
+			if (loadBinary(cacheFile)) {
+				nbCacheHits++;
+				linkedFromCache = true;
+				return;
+			}
+			nbCacheMisses++;
+		}
 		const GLchar* vShaderCode = vertexCode.c_str();
 		const GLchar * fShaderCode = fragmentCode.c_str();
 		// 2. Compile shaders
-		GLuint vertex, fragment;
-		GLint success;
-		GLchar infoLog[512];
 		// Vertex Shader
 		vertex = glCreateShader(GL_VERTEX_SHADER);
 		glShaderSource(vertex, 1, &vShaderCode, NULL);
 		glCompileShader(vertex);
-		// Print compile errors if any
-		glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
 		// Fragment Shader
 		fragment = glCreateShader(GL_FRAGMENT_SHADER);
 		glShaderSource(fragment, 1, &fShaderCode, NULL);
 		glCompileShader(fragment);
-		// Print compile errors if any
-		glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-		if (!success)
-		{
-			glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-		}
 		// Shader Program
 		this->ID = glCreateProgram();
 		glAttachShader(this->ID, vertex);
 		glAttachShader(this->ID, fragment);
+		if (!cacheFile.empty()) {
+			programParameteri(this->ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
 		glLinkProgram(this->ID);
-		// Print linking errors if any
-		glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
-		if (!success)
-		{
-			glGetProgramInfoLog(this->ID, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+	}
+
+	// Whether finish() can run without blocking; only known with KHR_parallel_shader_compile
+	bool isReady() const
+	{
+		if (linkedFromCache || !parallelCompile) {
+			return true;
+		}
+		GLint done = 0;
+		glGetProgramiv(this->ID, GL_COMPLETION_STATUS_KHR, &done);
+		return done != 0;
+	}
+
+	// Waits for compile() if needed, prints the errors if any and reads the uniforms of the program
+	bool finish()
+	{
+		GLint success = 1;
+		GLchar infoLog[512];
+		if (!linkedFromCache) {
+			// Print compile errors if any
+			glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+			if (!success)
+			{
+				glGetShaderInfoLog(vertex, 512, NULL, infoLog);
+				std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+			}
+			glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+			if (!success)
+			{
+				glGetShaderInfoLog(fragment, 512, NULL, infoLog);
+				std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+			}
+			// Print linking errors if any
+			glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+			if (!success)
+			{
+				glGetProgramInfoLog(this->ID, 512, NULL, infoLog);
+				std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+			}
+			else if (!cacheFile.empty()) {
+				storeBinary(cacheFile);
+			}
+			// Delete the shaders as they're linked into our program now and no longer necessery
+			glDeleteShader(vertex);
+			glDeleteShader(fragment);
+			vertex = fragment = 0;
 		}
-		// Delete the shaders as they're linked into our program now and no longer necessery
-		glDeleteShader(vertex);
-		glDeleteShader(fragment);
 
+		reflectUniforms();
+		return success != 0;
 	}
+
+	// Lets the driver compile on its own threads (KHR_parallel_shader_compile), so isReady() can be polled
+	static bool enableParallelCompile()
+	{
+		GLint nbExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &nbExtensions);
+		for (GLint i = 0; i < nbExtensions && !parallelCompile; i++) {
+			const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+			parallelCompile = extension != NULL && string((const char*)extension) == "GL_KHR_parallel_shader_compile";
+		}
+
+		MaxShaderCompilerThreadsProc maxShaderCompilerThreads = parallelCompile ? (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR") : NULL;
+		if (maxShaderCompilerThreads != NULL) {
+			// As many threads as the implementation likes
+			maxShaderCompilerThreads(0xFFFFFFFF);
+		}
+		return parallelCompile;
+	}
+
 	// Uses the current shader
 	void Use()
 	{
 		glUseProgram(this->ID);
 	}
 
+	// Resolves a handle once (e.g. after loading the shader) for use in the render loop
+	template<typename T>
+	T getUniform(const std::string& name) const
+	{
+		T handle;
+		unordered_map<string, ActiveUniform>::const_iterator found = uniforms.find(name);
+		if (found == uniforms.end()) {
+			return handle;
+		}
+		if (!T::accepts(found->second.type)) {
+			std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH: " << name << std::endl;
+			return handle;
+		}
+		handle.location = found->second.location;
+		return handle;
+	}
+
 	void setBool(const std::string& name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), (int)value);
+		glUniform1i(getLocation(name), (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string& name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+		glUniform1i(getLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string& name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(this->ID, name.c_str()), value);
+		glUniform1f(getLocation(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec3(const std::string& name, float v1, float v2, float v3) const
 	{
-		glUniform3f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3);
+		glUniform3f(getLocation(name), v1, v2, v3);
 	}
 
 	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) const
 	{
-		glUniform4f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3,v4);
+		glUniform4f(getLocation(name), v1, v2, v3,v4);
 	}
 
 	void setMat4(const std::string& name, float *v) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, v);
+		glUniformMatrix4fv(getLocation(name), 1, GL_FALSE, v);
+	}
+
+	// Handle overloads: no hashing and no driver lookup
+	void setInt(IntUniform uniform, int value) const
+	{
+		avoidedLookups++;
+		glUniform1i(uniform.location, value);
+	}
+
+	void setFloat(FloatUniform uniform, float value) const
+	{
+		avoidedLookups++;
+		glUniform1f(uniform.location, value);
+	}
+
+	void setVec3(Vec3Uniform uniform, float v1, float v2, float v3) const
+	{
+		avoidedLookups++;
+		glUniform3f(uniform.location, v1, v2, v3);
+	}
+
+	void setVec4(Vec4Uniform uniform, float v1, float v2, float v3, float v4) const
+	{
+		avoidedLookups++;
+		glUniform4f(uniform.location, v1, v2, v3, v4);
+	}
+
+	void setMat4(Mat4Uniform uniform, float *v) const
+	{
+		avoidedLookups++;
+		glUniformMatrix4fv(uniform.location, 1, GL_FALSE, v);
+	}
+
+	// Directory for linked program binaries, created on first use; empty (the default) disables the cache
+	static void setCacheDirectory(const std::string& directory) { cacheDirectory = directory; }
+	static int getNbCacheHits() { return nbCacheHits; }
+	static int getNbCacheMisses() { return nbCacheMisses; }
+
+	// Number of glGetUniformLocation calls saved since the last reset, meant to be read once per frame
+	int getAvoidedLookups() const { return avoidedLookups; }
+	void resetAvoidedLookups() { avoidedLookups = 0; }
+
+private:
+	struct ActiveUniform {
+		GLint location;
+		GLenum type;
+	};
+
+	unordered_map<string, ActiveUniform> uniforms;
+	mutable int avoidedLookups = 0;
+
+	// Between compile() and finish()
+	GLuint vertex = 0, fragment = 0;
+	string cacheFile;
+	bool linkedFromCache = false;
+
+	// Defined in Shader.cpp
+	static string cacheDirectory;
+	static int nbCacheHits;
+	static int nbCacheMisses;
+	static GetProgramBinaryProc getProgramBinary;
+	static ProgramBinaryProc programBinary;
+	static ProgramParameteriProc programParameteri;
+	static bool parallelCompile;
+
+	static bool loadBinaryFunctions()
+	{
+		if (getProgramBinary == NULL) {
+			GLint nbFormats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nbFormats);
+			if (nbFormats <= 0) {
+				return false;
+			}
+			getProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+			programBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+			programParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+		}
+		return getProgramBinary != NULL && programBinary != NULL && programParameteri != NULL;
+	}
+
+	// FNV-1a of both sources and of the driver strings, since a binary is only valid for the driver that made it
+	static string getCacheKey(const std::string& vertexCode, const std::string& fragmentCode)
+	{
+		const GLubyte* driver[] = { glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION) };
+		string key = vertexCode + '\0' + fragmentCode;
+		for (const GLubyte* text : driver) {
+			key += '\0';
+			key += text != NULL ? (const char*)text : "";
+		}
+
+		unsigned long long hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < key.size(); i++) {
+			hash = (hash ^ (unsigned char)key[i]) * 1099511628211ULL;
+		}
+
+		char name[17];
+		snprintf(name, sizeof(name), "%016llx", hash);
+		return name;
+	}
+
+	// File layout: the binary format enum followed by the blob returned by glGetProgramBinary
+	bool loadBinary(const std::string& filename)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		GLenum format = 0;
+		if (!file.read((char*)&format, sizeof(format))) {
+			return false;
+		}
+		std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		this->ID = glCreateProgram();
+		programBinary(this->ID, format, binary.data(), (GLsizei)binary.size());
+
+		// Drivers reject binaries from other versions even when the strings match, so the link status is the final word
+		GLint success = 0;
+		glGetProgramiv(this->ID, GL_LINK_STATUS, &success);
+		if (!success) {
+			glDeleteProgram(this->ID);
+			this->ID = 0;
+		}
+		return success != 0;
+	}
+
+	void storeBinary(const std::string& filename) const
+	{
+		GLint length = 0;
+		glGetProgramiv(this->ID, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) {
+			return;
+		}
+
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		getProgramBinary(this->ID, length, NULL, &format, binary.data());
+
+#ifdef _WIN32
+		_mkdir(cacheDirectory.c_str());
+#else
+		mkdir(cacheDirectory.c_str(), 0755);
+#endif
+		std::ofstream file(filename, std::ios::binary);
+		if (!file.is_open()) {
+			std::cout << "Unable to open the file: " << filename << std::endl;
+			return;
+		}
+		file.write((const char*)&format, sizeof(format));
+		file.write(binary.data(), binary.size());
+	}
+
+	// Reads every active uniform of the linked program into the table, so no setter asks the driver again
+	void reflectUniforms()
+	{
+		uniforms.clear();
+		GLint nbUniforms = 0, maxLength = 0;
+		glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &nbUniforms);
+		glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+		std::vector<GLchar> name(maxLength > 0 ? maxLength : 1);
+		for (GLint i = 0; i < nbUniforms; i++)
+		{
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = GL_NONE;
+			glGetActiveUniform(this->ID, i, (GLsizei)name.size(), &length, &size, &type, name.data());
+
+			// Uniforms inside blocks have no location of their own
+			GLint location = glGetUniformLocation(this->ID, name.data());
+			if (location < 0) {
+				continue;
+			}
+
+			ActiveUniform uniform = { location, type };
+			string uniformName(name.data(), length);
+			uniforms[uniformName] = uniform;
+
+			// Arrays are reported as "name[0]" but are also set through the plain name
+			if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0) {
+				uniforms[uniformName.substr(0, uniformName.size() - 3)] = uniform;
+			}
+		}
+	}
+
+	GLint getLocation(const std::string& name) const
+	{
+		avoidedLookups++;
+		unordered_map<string, ActiveUniform>::const_iterator found = uniforms.find(name);
+		return found != uniforms.end() ? found->second.location : -1;
 	}
 };
 
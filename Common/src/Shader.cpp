@@ -1,3 +1,11 @@
 #pragma once
 
-#include "Shader.h"
\ No newline at end of file
+#include "Shader.h"
+
+string Shader::cacheDirectory;
+int Shader::nbCacheHits = 0;
+int Shader::nbCacheMisses = 0;
+GetProgramBinaryProc Shader::getProgramBinary = NULL;
+ProgramBinaryProc Shader::programBinary = NULL;
+ProgramParameteriProc Shader::programParameteri = NULL;
+bool Shader::parallelCompile = false;
@@ -10,9 +10,21 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include "stb_image.h"
 #include "Shader.h"
+#include "ShaderLibrary.h"
 #include "Bezier.h"
+#include "CurveAnimator.h"
+#include "ObjReader.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "Renderer.h"
+#include "TextureLoader.h"
+#include "MeshCache.h"
+#include "ObjBenchmark.h"
+#include "CurveBenchmark.h"
+#include "TextureAtlas.h"
+#include "TextureArrays.h"
+#include "ParseUtils.h"
 
 using namespace std;
 
@@ -21,10 +33,8 @@ const GLuint WIDTH = 1000, HEIGHT = 1000;
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void moveObject(glm::mat4& model, glm::vec3 coord);
-void loadMtl(string filename, map<string, string>& properties);
-int loadObj(string objFile, int& verticesSize);
-int loadTexture(string path);
-float stringToFloat(string value, float def);
+void loadMtl(string filename, Material& material, TextureLoader& textures, const TextureAtlas& atlas, TextureArrays* arrays);
+void loadObj(string objFile, Mesh& mesh, ThreadPool* pool);
 vector<glm::vec3> createControlPoints(string filename);
 vector<string> split(const string& input, char delimiter);
 
@@ -32,33 +42,60 @@ bool rotateX = false, rotateY = false, rotateZ = false, firstMouse = true;
 float lastX, lastY, sensitivity = 0.05, pitch = 0.0, yaw = -90.0;
 vector<int> objectsMovementControl;
 
-int shieldVertSize = 0, SHIELD_MOVE_KEY = GLFW_KEY_1;
-int ballVerticesSize = 0, MEMORY_CARD_MOVE_KEY = GLFW_KEY_2;
+int SHIELD_MOVE_KEY = GLFW_KEY_1;
+int MEMORY_CARD_MOVE_KEY = GLFW_KEY_2;
 
 glm::vec3 cameraPos = glm::vec3(0.0, 0.0, 10.0);
 glm::vec3 cameraFront = glm::vec3(0.0, 0.0, -1.0);
 glm::vec3 cameraUp = glm::vec3(0.0, 1.0, 0.0);
 
-struct Vertex {
-	float x, y, z, r = 0.1f, g = 0.1f, b = 0.1f;
-};
+int main(int argc, char** argv)
+{
+	// Exericio8 --bench-obj <file.obj> [iterations]
+	if (argc >= 3 && string(argv[1]) == "--bench-obj")
+	{
+		ObjBenchmark benchmark(argc >= 4 ? stoi(argv[3]) : 5);
+		benchmark.run(argv[2]);
+		return 0;
+	}
 
-struct Texture {
-	float s, t;
-};
+	// Exericio8 --bench-curve <curves.txt> [points per segment] [iterations]
+	if (argc >= 3 && string(argv[1]) == "--bench-curve")
+	{
+		CurveBenchmark benchmark(argc >= 4 ? stoi(argv[3]) : 1200, argc >= 5 ? stoi(argv[4]) : 100);
+		benchmark.run(createControlPoints(argv[2]));
+		return 0;
+	}
 
-struct Normal {
-	float x, y, z;
-};
+	// Exericio8 --bake-mips <image> [image...], block compressed like at load time
+	if (argc >= 3 && string(argv[1]) == "--bake-mips")
+	{
+		for (int arg = 2; arg < argc; arg++) {
+			bool baked = MipChain::bake(argv[arg], true, true);
+			cout << (baked ? "Baked " : "Unable to bake ") << MipChain::getCachePath(argv[arg]) << endl;
+		}
+		return 0;
+	}
 
-struct Face {
-	Vertex vertices[3];
-	Texture textures[3];
-	Normal normals[3];
-};
+	// Exericio8 --build-atlas <name> <page size> <file.mtl|image> [...], writes <name>.atlas and <name>_<page>.tga
+	if (argc >= 5 && string(argv[1]) == "--build-atlas")
+	{
+		TextureAtlas atlas(stoi(argv[3]));
+		for (int arg = 4; arg < argc; arg++) {
+			string source = argv[arg];
+			if (source.size() > 4 && source.substr(source.size() - 4) == ".mtl") {
+				atlas.addMtl(source);
+			}
+			else {
+				atlas.addImage(source);
+			}
+		}
+		return atlas.build(argv[2]) ? 0 : 1;
+	}
+
+	// Exericio8 --texture-arrays: diffuse maps of the same size and format share a GL_TEXTURE_2D_ARRAY
+	bool useTextureArrays = argc >= 2 && string(argv[1]) == "--texture-arrays";
 
-int main()
-{
 	glfwInit();
 	GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "GB - Jose Costa", nullptr, nullptr);
 	glfwMakeContextCurrent(window);
@@ -81,32 +118,71 @@ int main()
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
 
-	Shader shader("../shaders/shaders.vs", "../shaders/shaders.fs");
+	// Camera and light go to the FrameData block; lightPos and lightColor never change
+	FrameUniforms frame;
+	frame.projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
+	frame.lightPos[0] = glm::vec4(15.0f, 15.0f, 2.0f, 1.0f);
+	frame.lightColor[0] = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 
-	glUseProgram(shader.ID);
+	Renderer sceneRenderer;
+	sceneRenderer.init();
 
-	glm::mat4 view = glm::lookAt(glm::vec3(0.0, 0.0, 3.0), glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.0, 1.0, 0.0));
-	shader.setMat4("view", value_ptr(view));
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
-	shader.setMat4("projection", glm::value_ptr(projection));
-	glm::mat4 model = glm::mat4(1);
-	model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-	shader.setMat4("model", glm::value_ptr(model));
-	glUniform1i(glGetUniformLocation(shader.ID, "tex_buffer"), 0);
+	// Loading the 3D Models
+	ThreadPool loaderPool;
+
+	// Images are decoded on the pool and uploaded from the render loop, 4 MB per frame at most
+	TextureLoader textures;
+	textures.setThreadPool(&loaderPool);
+	textures.setUploadBudget(4 * 1024 * 1024);
+
+	// Diffuse maps listed in the atlas manifest, if one was built, are sampled from its pages instead
+	TextureAtlas atlas;
+	atlas.load("../3d-models/textures.atlas");
+
+	TextureArrays arrays;
+	arrays.setThreadPool(&loaderPool);
+	arrays.setAnisotropy(textures.getAnisotropy());
+	arrays.setCompression(textures.getCompression());
+	TextureArrays* materialArrays = useTextureArrays ? &arrays : NULL;
+
+	Mesh shieldMesh;
+	loadObj("../3d-models/shield/Shield.obj", shieldMesh, &loaderPool);
+	Material shieldMaterial;
+	loadMtl("../3d-models/shield/Shield.mtl", shieldMaterial, textures, atlas, materialArrays);
+
+	Mesh memoryCardMesh;
+	loadObj("../3d-models/memory-card/MemoryCard.obj", memoryCardMesh, &loaderPool);
+	Material memoryCardMaterial;
+	loadMtl("../3d-models/memory-card/MemoryCard.mtl", memoryCardMaterial, textures, atlas, materialArrays);
+
+	// The arrays need every image before they can be created, so their textures are only known now
+	if (useTextureArrays) {
+		arrays.build();
+		Material* materials[] = { &shieldMaterial, &memoryCardMaterial };
+		for (Material* material : materials) {
+			TextureLayer layer = arrays.find(material->mapKd);
+			material->texKd = layer.array;
+			material->layer = layer.layer;
+		}
+		cout << arrays.getNbLayers() << " textures in " << arrays.getNbArrays() << " array(s)" << endl;
+	}
 
-	shader.setVec3("lightPosition", 15.0f, 15.0f, 2.0f);
-	shader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+	int shieldMaterialId = sceneRenderer.addMaterial(shieldMaterial);
+	int memoryCardMaterialId = sceneRenderer.addMaterial(memoryCardMaterial);
+	sceneRenderer.uploadMaterials();
 
-	// Loading the 3D Models
-	GLuint shieldVAO = loadObj("../3d-models/shield/Shield.obj", shieldVertSize);
-	map<string, string> shieldProps;
-	loadMtl("../3d-models/shield/Shield.mtl", shieldProps);
-	GLuint textShield = loadTexture(shieldProps["map_Kd"]);
+	// One program per feature set the materials use; linked programs are reused across launches, see Shader::loadBinary
+	Shader::setCacheDirectory("../shaders/cache");
+	ShaderLibrary shaders("../shaders/shaders.vs", "../shaders/shaders.fs");
+	unsigned int shieldFeatures = ShaderLibrary::getFeatures(shieldMaterial, false);
+	unsigned int memoryCardFeatures = ShaderLibrary::getFeatures(memoryCardMaterial, false);
+	shaders.build({ shieldFeatures, memoryCardFeatures });
+	cout << "Program cache: " << Shader::getNbCacheHits() << " hits / " << Shader::getNbCacheMisses() << " misses" << endl;
+	Shader* shieldShader = shaders.get(shieldFeatures);
+	Shader* memoryCardShader = shaders.get(memoryCardFeatures);
 
-	GLuint memoryCardVAO = loadObj("../3d-models/memory-card/MemoryCard.obj", ballVerticesSize);
-	map<string, string> memoryCardProps;
-	loadMtl("../3d-models/memory-card/MemoryCard.mtl", memoryCardProps);
-	GLuint texMemoryCard = loadTexture(memoryCardProps["map_Kd"]);
+	// Saving shaders.vs, shaders.fs or common.glsl rebuilds the variants without restarting the viewer
+	shaders.enableHotReload(window);
 
 	glEnable(GL_DEPTH_TEST);
 
@@ -114,62 +190,51 @@ int main()
 
 	Bezier bezier;
 	bezier.setControlPoints(controlPoints);
-	bezier.setShader(&shader);
-	bezier.generateCurve(1200);
-
-	int nbCurvePoints = bezier.getNbCurvePoints();
-	int i = 0;
+	bezier.setShader(shieldShader);
+	// Objects move along the curve at a constant speed, and the points only go where the curve bends
+	bezier.generateCurveAdaptive(0.001f);
+	cout << "Curve: " << bezier.getNbCurvePoints() << " points" << endl;
+	CurveAnimator curveAnimator(&bezier, 0.1f, CurveAnimator::LOOP);
+	double lastFrameTime = glfwGetTime();
+	double lastStatsTime = lastFrameTime;
 
 	while (!glfwWindowShouldClose(window))
 	{
 		glfwPollEvents();
 
+		double frameTime = glfwGetTime();
+		curveAnimator.update((float)(frameTime - lastFrameTime));
+		lastFrameTime = frameTime;
+
+		textures.update();
+		shaders.update();
+
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		glLineWidth(10);
 		glPointSize(20);
 
-		model = glm::mat4(1);
-
-		glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-		shader.setMat4("view", glm::value_ptr(view));
-		shader.setVec3("cameraPos", cameraPos.x, cameraPos.y, cameraPos.z);
-		shader.setMat4("model", glm::value_ptr(model));
+		frame.view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+		frame.cameraPos = glm::vec4(cameraPos, 1.0f);
+		sceneRenderer.beginFrame(frame);
 
 		// ##############
 		// SHIELD SECTION
 		// ##############
-		glBindVertexArray(shieldVAO);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, textShield);
-
-		model = glm::mat4(1);
+		glm::mat4 model = glm::mat4(1);
 		model = glm::scale(model, glm::vec3(2.0, 2.0, 2.0));
 		model = glm::rotate(model, glm::radians(45.0f), glm::vec3(1.0f, 1.0f, 1.0f));
 
 		if (find(objectsMovementControl.begin(), objectsMovementControl.end(), SHIELD_MOVE_KEY) != objectsMovementControl.end())
 		{
-			moveObject(model, bezier.getPointOnCurve(i));
+			moveObject(model, curveAnimator.getPosition());
 		}
 
-		shader.setMat4("model", glm::value_ptr(model));
-
-		shader.setFloat("ka", stringToFloat(shieldProps["Ka"], 0));
-		shader.setFloat("kd", stringToFloat(shieldProps["Kd"], 1.5));
-		shader.setFloat("ks", stringToFloat(shieldProps["Ks"], 0));
-		shader.setFloat("q", stringToFloat(shieldProps["Ns"], 0));
-
-		glDrawArrays(GL_TRIANGLES, 0, shieldVertSize);
+		sceneRenderer.submit(shieldShader, shieldMaterialId, shieldMesh, model);
 
 		// ###################
 		// MEMORY CARD SECTION
 		// ###################
-		glBindVertexArray(memoryCardVAO);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texMemoryCard);
-
 		model = glm::mat4(1);
 		model = glm::scale(model, glm::vec3(1.0, 1.0, 1.0));
 		model = glm::translate(model, glm::vec3(4.5, -1.0, 0.0));
@@ -177,27 +242,33 @@ int main()
 
 		if (find(objectsMovementControl.begin(), objectsMovementControl.end(), MEMORY_CARD_MOVE_KEY) != objectsMovementControl.end())
 		{
-			moveObject(model, bezier.getPointOnCurve(i));
+			moveObject(model, curveAnimator.getPosition());
 		}
 
-		shader.setMat4("model", glm::value_ptr(model));
-		shader.setFloat("ka", stringToFloat(memoryCardProps["Ka"], 0));
-		shader.setFloat("kd", stringToFloat(memoryCardProps["Kd"], 1.5));
-		shader.setFloat("ks", stringToFloat(memoryCardProps["Ks"], 0));
-		shader.setFloat("q", stringToFloat(memoryCardProps["Ns"], 0));
+		sceneRenderer.submit(memoryCardShader, memoryCardMaterialId, memoryCardMesh, model);
 
-		glDrawArrays(GL_TRIANGLES, 0, ballVerticesSize);
+		sceneRenderer.flush();
 
-		i = (i + 1) % nbCurvePoints;
-
-		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		if (glfwGetTime() - lastStatsTime >= 1.0) {
+			cout << "Uniform lookups avoided per frame: " << shaders.getAvoidedLookups()
+				<< ", draws: " << sceneRenderer.getNbDraws() << ", binds skipped: " << sceneRenderer.getNbSkippedBinds()
+				<< ", textures: " << textures.getNbHits() << " hits / " << textures.getNbMisses() << " misses, "
+				<< textures.getResidentBytes() / (1024 * 1024) << " MB resident" << endl;
+			lastStatsTime = glfwGetTime();
+		}
+		shaders.resetAvoidedLookups();
 
 		glfwSwapBuffers(window);
 	}
 
-	glDeleteVertexArrays(1, &shieldVAO);
-	glDeleteVertexArrays(1, &memoryCardVAO);
+	shieldMesh.destroy();
+	memoryCardMesh.destroy();
+	bezier.destroy();
+	sceneRenderer.destroy();
+	shaders.destroy();
+	textures.release(shieldMaterial.texKd);
+	textures.release(memoryCardMaterial.texKd);
+	arrays.destroy();
 
 	glfwTerminate();
 
@@ -291,136 +362,30 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 	cameraFront = glm::normalize(front);
 }
 
-int loadObj(string filename, int& verticesSize)
+void loadObj(string filename, Mesh& mesh, ThreadPool* pool)
 {
-	vector<float> vertices;
-
-	ifstream file(filename);
-
-	vector<Vertex> uniqueVertices;
-	vector<Texture> uniqueTextures;
-	vector<Normal> uniqueNormals;
-	vector<Face> faces;
-
-	vector<float> buffer;
-
-	if (file.is_open()) {
-		string line;
-
-		while (getline(file, line)) {
-			vector<string> row = split(line, ' ');
-
-			bool isVertice = row[0] == "v";
-			bool isFace = row[0] == "f";
-			bool isTexture = row[0] == "vt";
-			bool isNormal = row[0] == "vn";
-
-			if (isVertice) {
-				float x = stof(row[1]), y = stof(row[2]), z = stof(row[3]);
-
-				Vertex vertex;
-
-				vertex.x = x;
-				vertex.y = y;
-				vertex.z = z;
-
-				uniqueVertices.push_back(vertex);
-			}
-
-			if (isTexture) {
-				float x = stof(row[1]), y = stof(row[2]);
-
-				Texture texture;
-
-				texture.s = x;
-				texture.t = y;
-
-				uniqueTextures.push_back(texture);
-			}
-
-			if (isNormal) {
-				float x = stof(row[1]), y = stof(row[2]), z = stof(row[3]);
+	mesh.setName(filename);
 
-				Normal normal;
-
-				normal.x = x;
-				normal.y = y;
-				normal.z = z;
-
-				uniqueNormals.push_back(normal);
-			}
-
-			if (isFace) {
-				vector<string> x = split(row[1], '/'), y = split(row[2], '/'), z = split(row[3], '/');
-
-				int v1 = stoi(x[0]) - 1, v2 = stoi(y[0]) - 1, v3 = stoi(z[0]) - 1;
-				int t1 = stoi(x[1]) - 1, t2 = stoi(y[1]) - 1, t3 = stoi(z[1]) - 1;
-				int n1 = stoi(x[2]) - 1, n2 = stoi(y[2]) - 1, n3 = stoi(z[2]) - 1;
-
-				Face face;
-
-				face.vertices[0] = uniqueVertices[v1];
-				face.textures[0] = uniqueTextures[t1];
-				face.normals[0] = uniqueNormals[n1];
-
-				face.vertices[1] = uniqueVertices[v2];
-				face.textures[1] = uniqueTextures[t2];
-				face.normals[1] = uniqueNormals[n2];
+	// A valid binary cache is uploaded straight from its mapping; otherwise parse the text and refresh the cache
+	MeshCache cache;
+	if (cache.load(filename, mesh)) {
+		return;
+	}
 
-				face.vertices[2] = uniqueVertices[v3];
-				face.textures[2] = uniqueTextures[t3];
-				face.normals[2] = uniqueNormals[n3];
+	ObjReader reader;
+	reader.setThreadPool(pool);
 
-				faces.push_back(face);
-			}
-		}
-
-		file.close();
+	if (!reader.read(filename)) {
+		cout << "Unable to open the file: " << filename << endl;
+		return;
+	}
 
-		for (Face face : faces)
-		{
-			for (int i = 0; i < 3; i++)
-			{
-				buffer.push_back(face.vertices[i].x);
-				buffer.push_back(face.vertices[i].y);
-				buffer.push_back(face.vertices[i].z);
-
-				buffer.push_back(face.vertices[i].r);
-				buffer.push_back(face.vertices[i].g);
-				buffer.push_back(face.vertices[i].b);
-
-				buffer.push_back(face.textures[i].s);
-				buffer.push_back(face.textures[i].t);
-
-				buffer.push_back(face.normals[i].x);
-				buffer.push_back(face.normals[i].y);
-				buffer.push_back(face.normals[i].z);
-			}
-		}
+	MeshData data = Mesh::pack(reader.getVertices(), reader.getIndices());
+	mesh.upload(data);
 
-		vertices = buffer;
-	}
-	else {
-		cout << "Unable to open the file: " << filename << endl;
+	if (!cache.store(data)) {
+		cout << "Unable to write the mesh cache: " << MeshCache::getCachePath(filename) << endl;
 	}
-	verticesSize = vertices.size();
-	GLuint VBO, VAO;
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-	return VAO;
 }
 
 vector<glm::vec3> createControlPoints(string filename)
@@ -467,60 +432,54 @@ vector<string> split(const string& input, char delimiter) {
 	return tokens;
 }
 
-int loadTexture(string path)
-{
-	GLuint tex;
-
-	glGenTextures(1, &tex);
-	glBindTexture(GL_TEXTURE_2D, tex);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, nrChannels;
-	unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-
-	if (data)
-	{
-		if (nrChannels == 3) //jpg, bmp
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		}
-		else //png
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		}
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
-	{
-		std::cout << "Failed to load texture" << std::endl;
-	}
-
-	stbi_image_free(data);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	return tex;
-}
-
-void loadMtl(string filename, map<string, string>& properties) {
+// Reads the first material of the file; the values are parsed here once instead of on every frame
+void loadMtl(string filename, Material& material, TextureLoader& textures, const TextureAtlas& atlas, TextureArrays* arrays) {
 	ifstream file(filename);
 
 	if (file.is_open()) {
 		string line;
 
 		while (getline(file, line)) {
-			vector<string> row = split(line, ' ');
+			istringstream row(line);
+			string key;
 
-			if (row.size() == 0) {
+			if (!(row >> key) || key[0] == '#') {
 				continue;
 			}
 
-			properties[row[0]] = row[1];
+			if (key == "newmtl") {
+				if (!material.name.empty()) {
+					break;
+				}
+				row >> material.name;
+			}
+			else if (key == "Ka") {
+				row >> material.ka.r >> material.ka.g >> material.ka.b;
+			}
+			else if (key == "Kd") {
+				row >> material.kd.r >> material.kd.g >> material.kd.b;
+			}
+			else if (key == "Ks") {
+				row >> material.ks.r >> material.ks.g >> material.ks.b;
+			}
+			else if (key == "Ns") {
+				row >> material.ns;
+			}
+			else if (key == "Ni") {
+				row >> material.ni;
+			}
+			else if (key == "d") {
+				row >> material.d;
+			}
+			else if (key == "illum") {
+				row >> material.illum;
+			}
+			else if (key == "map_Kd") {
+				material.mapKd = readRest(row);
+			}
+			else if (key == "map_Ks") {
+				material.mapKs = readRest(row);
+			}
 		}
 
 		file.close();
@@ -528,14 +487,21 @@ void loadMtl(string filename, map<string, string>& properties) {
 	else {
 		cout << "Unable to open the file: " << filename << endl;
 	}
-}
 
-// Utilizado para previnir converso de valor nulo
-float stringToFloat(string value, float def) {
-	if (value.empty()) {
-		return def;
+	// Materials whose map was packed share the atlas page, the cache hands out one texture for all of them
+	const AtlasEntry* entry = atlas.find(material.mapKd);
+	if (entry != NULL) {
+		material.mapKd = atlas.getPageFile(entry->page);
+		material.uvTransform = entry->uvTransform;
+	}
+
+	// Only the diffuse map is sampled by shaders.fs
+	if (arrays != NULL) {
+		arrays->add(material.mapKd);
+	}
+	else if (!material.mapKd.empty()) {
+		material.texKd = textures.load(material.mapKd);
 	}
-	return stof(value);
 }
 
 void moveObject(glm::mat4& model, glm::vec3 coord) {
@@ -0,0 +1,10 @@
+#pragma once
+#include "Curve.h"
+// Uniform cubic B-spline: C2 continuous, each new control point adds a segment, and the curve
+// passes near the control points rather than through them
+class BSpline :
+    public Curve
+{
+public:
+    BSpline();
+};
@@ -5,6 +5,4 @@ class Bezier :
 {
 public:
     Bezier();
-    void generateCurve(int pointsPerSegment);
 };
-
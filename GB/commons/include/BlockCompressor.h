@@ -0,0 +1,16 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+// CPU encoders for the S3TC block formats: BC1 (8 bytes per 4x4 block, opaque) and BC3 (16 bytes,
+// BC1 color plus an interpolated alpha block). Endpoints are fitted along the principal axis of each
+// block's colors. Images whose sides are not multiples of 4 repeat their edge texels into the padding.
+class BlockCompressor
+{
+public:
+	static void compressBC1(const unsigned char* rgba, int width, int height, vector<unsigned char>& out);
+	static void compressBC3(const unsigned char* rgba, int width, int height, vector<unsigned char>& out);
+	static size_t getCompressedSize(int width, int height, int blockSize) { return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize; }
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include "Curve.h"
+// Interpolating spline: each segment goes from controlPoints[k + 1] to controlPoints[k + 2], with
+// the points around them setting the tangents, so every control point but the first and the last
+// is on the curve
+class CatmullRom :
+    public Curve
+{
+public:
+    // alpha 0 is the uniform spline, 0.5 the centripetal one, which does not overshoot or form
+    // loops where the control points are unevenly spaced
+    CatmullRom(float alpha = 0.0f);
+protected:
+    glm::mat4x3 getGeometry(int first) const;
+private:
+    float alpha;
+};
@@ -9,6 +9,9 @@
 #include <vector> 
 
 #include "Shader.h"
+#include "DrawValidator.h"
+#include "CurveBvh.h"
+#include "FenwickTree.h"
 
 using namespace std;
 
@@ -16,17 +19,67 @@ class Curve
 {
 public:
 	Curve() {}
+	virtual ~Curve() {}
 	inline void setControlPoints(vector <glm::vec3> controlPoints) { this->controlPoints = controlPoints; }
 	void setShader(Shader* shader);
+	// Every curve type goes through these: segment k uses the control points from k * stride, its
+	// geometry matrix comes from getGeometry() and its basis matrix is M
+	int getNbSegments() const;
 	void generateCurve(int pointsPerSegment);
+	// Points where the curvature needs them: no piece of the polyline is further than tolerance from the curve
+	void generateCurveAdaptive(float tolerance);
+	// Moves one control point of a generated curve: only the segments that use it are evaluated
+	// again, and only their points are sent to the buffer
+	void setControlPoint(int i, const glm::vec3& point);
+	void destroy();
 	void drawCurve(glm::vec4 color);
-	int getNbCurvePoints() { return curvePoints.size(); }
-	glm::vec3 getPointOnCurve(int i) { return curvePoints[i]; }
+	// Points of the polyline, without the start of each segment that repeats the end of the previous one
+	int getNbCurvePoints() const { return segmentPoints.total(); }
+	glm::vec3 getPointOnCurve(int i) const;
+	// Constant-speed sampling through the arc-length table built by generateCurve
+	float getLength() const { return segmentLengths.total(); }
+	glm::vec3 pointAtDistance(float distance) const;
+	glm::vec3 pointAtTime(float time, float speed) const;
+	// Closest point of the curve itself (not of its polyline); the distance is negative when the curve has no segments
+	CurveHit closestPoint(const glm::vec3& p) const;
 protected:
+	static const int MAX_SUBDIVISIONS = 16;
+
+	// Geometry matrix of the segment that starts at control point first; by default the four points themselves
+	virtual glm::mat4x3 getGeometry(int first) const;
+	void tessellate();
+	// Appends the points of segment k, with the sampling of the last generateCurve or generateCurveAdaptive
+	void tessellateSegment(int k, vector<glm::vec3>& out) const;
+	void subdivide(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, int depth, vector<glm::vec3>& out) const;
+	void updateSegments(int first, int last);
+	void resizeSlots(int size);
+	int getNbVisiblePoints(int k) const;
+	float updateArcLengths(int k);
+	void createBuffers();
+	void uploadPoints(int first, int count);
 	vector <glm::vec3> controlPoints;
+	// Segment k has segmentCounts[k] points from k * slotSize, the rest of its slot is free
 	vector <glm::vec3> curvePoints;
+	int slotSize = 0;
+	vector <GLint> slotFirsts;
+	vector <GLsizei> segmentCounts;
+	// Sampling in use: a fixed number of points per segment, or a tolerance when pointsPerSegment is 0
+	int pointsPerSegment = 0;
+	float tolerance = 0.0f;
+	// Distance along the polyline from the start of the segment to each curve point, in the same
+	// slots, with the length and the number of visible points of each segment
+	vector <float> arcLengths;
+	FenwickTree <float> segmentLengths;
+	FenwickTree <int> segmentPoints;
+	CurveBvh bvh;
 	glm::mat4 M; //Matriz de base
-	GLuint VAO;
+	// Control points between the starts of two segments: 3 when segments share end points, 1 for splines
+	int stride = 3;
+	string name = "Curve";
+	GLuint VAO = 0;
+	GLuint VBO = 0;
+	// Points the VBO can hold
+	int capacity = 0;
 	Shader* shader;
 };
 
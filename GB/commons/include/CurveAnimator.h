@@ -0,0 +1,36 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Curve.h"
+
+using namespace std;
+
+// Moves a point along a curve at a constant speed, driven by the time elapsed between frames
+// rather than by the frame count, so the motion is the same at any frame rate. The position is
+// interpolated between the curve points through the arc-length table, so fewer points only make
+// the path coarser, not the motion jumpier.
+class CurveAnimator
+{
+public:
+	// LOOP starts over at the end, PING_PONG turns back at each end, CLAMP stops at the end
+	enum Mode { LOOP, PING_PONG, CLAMP };
+
+	CurveAnimator(const Curve* curve, float speed, Mode mode = LOOP) : curve(curve), speed(speed), mode(mode) {}
+	inline void setSpeed(float speed) { this->speed = speed; }
+	inline void setMode(Mode mode) { this->mode = mode; }
+	// Speed that takes the given number of seconds from one end of the curve to the other
+	void setDuration(float seconds);
+	void update(float deltaTime);
+	void reset() { travelled = 0.0f; }
+	float getDistance() const;
+	glm::vec3 getPosition() const { return curve->pointAtDistance(getDistance()); }
+	bool isFinished() const { return mode == CLAMP && travelled >= curve->getLength(); }
+private:
+	const Curve* curve;
+	float speed;
+	Mode mode;
+	// Distance moved so far, kept within one period of the mode so it does not lose precision over time
+	float travelled = 0.0f;
+};
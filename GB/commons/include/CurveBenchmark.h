@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Measures curve evaluation throughput (points/s) of the CurveEvaluator against the original loop, which multiplied
+// G * M * T for every sample and pushed the points one by one. That loop is kept here only as the reference.
+class CurveBenchmark
+{
+public:
+	CurveBenchmark(int pointsPerSegment, int iterations) : pointsPerSegment(pointsPerSegment), iterations(iterations) {}
+	void run(const vector<glm::vec3>& controlPoints);
+private:
+	int pointsPerSegment;
+	int iterations;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Result of a closest-point query: t is the curve parameter, the segment index plus the position
+// in the segment (so 2.5 is the middle of the third segment)
+struct CurveHit {
+	float t;
+	glm::vec3 point;
+	float distance;
+};
+
+// Bounding volume hierarchy over the segments of a curve, for closest-point queries. Each leaf
+// holds one segment and the box of its Bezier control points, which contains the segment (convex
+// hull property). A query walks the tree nearest child first, skips every box further than the
+// best hit so far, and refines the point on the segments it reaches with Newton's method on the
+// cubic itself rather than on the tessellated points.
+class CurveBvh
+{
+public:
+	CurveBvh() {}
+	// Segments in power form: the columns are the coefficients of t^3, t^2, t and 1, as in G * M
+	void build(const vector<glm::mat4x3>& segments);
+	// Replaces segment k and refits the boxes from its leaf up to the root
+	void update(int k, const glm::mat4x3& segment);
+	bool closestPoint(const glm::vec3& p, CurveHit& hit) const;
+	int getNbSegments() const { return segments.size(); }
+private:
+	static const int MAX_DEPTH = 64;
+	static const int NB_SEEDS = 16;
+	static const int NB_ITERATIONS = 8;
+	static const int NB_HALVINGS = 4;
+
+	struct Node {
+		glm::vec3 min;
+		glm::vec3 max;
+		int left;
+		int right;
+		int parent;
+		int segment;
+	};
+
+	int buildNode(vector<int>& order, const vector<glm::vec3>& centers, int first, int last, int parent);
+	void getBounds(int k, glm::vec3& min, glm::vec3& max) const;
+	float closestOnSegment(int k, const glm::vec3& p, float& t) const;
+	static float getDistance2(const Node& node, const glm::vec3& p);
+
+	vector<glm::mat4x3> segments;
+	vector<Node> nodes;
+	// Leaf node of each segment
+	vector<int> leaves;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Power-basis form of one cubic segment, p(t) = ((a * t + b) * t + c) * t + d, with one array per
+// axis so that several t values go through the Horner steps side by side
+struct CubicSegment {
+	float a[3], b[3], c[3], d[3];
+};
+
+// Batch evaluation of cubic segments. The geometry and basis matrices are multiplied once per
+// segment (instead of once per sample), and samples are evaluated 8 at a time with AVX, 4 with
+// SSE2, or one by one when neither is available. The AVX loop is built on its own for AVX and only
+// called when the CPU and OS support it, so the program still runs on a CPU without AVX.
+class CurveEvaluator
+{
+public:
+	static CubicSegment makeSegment(const glm::mat4x3& G, const glm::mat4& M);
+	// Writes the points at t = 0, step, 2 * step, ... (nbSamples of them) to out
+	static void evaluate(const CubicSegment& segment, int nbSamples, float step, glm::vec3* out);
+	// "AVX", "SSE2" or "scalar": the widest path evaluate() takes on this machine
+	static const char* getInstructionSet();
+	static int getNbLanes();
+private:
+	static bool hasAvx();
+	// Defined in CurveEvaluatorAvx.cpp; evaluates the first samples 8 at a time and returns how many
+	static int evaluateAvx(const CubicSegment& segment, int nbSamples, float step, glm::vec3* out);
+};
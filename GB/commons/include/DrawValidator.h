@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+//GLAD
+#include <glad/glad.h>
+
+using namespace std;
+
+// Debug-build check of draw submissions: every VAO registers the size of its buffers once, and each
+// draw call is checked against them before it reaches the driver. An out-of-range draw is logged with
+// the mesh name (once per VAO) and skipped. In release builds the checks compile to nothing.
+class DrawValidator
+{
+public:
+#ifdef _DEBUG
+	static void track(GLuint VAO, const string& name, int nbVertices, int nbIndices, GLenum indexType, unsigned int maxIndex);
+	static void untrack(GLuint VAO);
+	static bool checkArrays(GLuint VAO, GLint first, GLsizei count);
+	static bool checkElements(GLuint VAO, GLsizei count, GLenum indexType, const void* offset);
+#else
+	static void track(GLuint, const string&, int, int, GLenum, unsigned int) {}
+	static void untrack(GLuint) {}
+	static bool checkArrays(GLuint, GLint, GLsizei) { return true; }
+	static bool checkElements(GLuint, GLsizei, GLenum, const void*) { return true; }
+#endif
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+// Binary indexed tree over a list of values: changing a value, the sum of the first k values, and
+// finding the value in which a running total falls all take O(log n)
+template <typename T>
+class FenwickTree
+{
+public:
+	FenwickTree() {}
+
+	void assign(const vector<T>& values)
+	{
+		this->values = values;
+		tree.assign(values.size() + 1, T());
+		for (size_t i = 1; i < tree.size(); i++) {
+			tree[i] += values[i - 1];
+			size_t parent = i + lowestBit(i);
+			if (parent < tree.size()) {
+				tree[parent] += tree[i];
+			}
+		}
+
+		highestStep = 1;
+		while (highestStep * 2 <= values.size()) {
+			highestStep *= 2;
+		}
+	}
+
+	int size() const { return values.size(); }
+	T get(int i) const { return values[i]; }
+
+	void set(int i, T value)
+	{
+		T delta = value - values[i];
+		values[i] = value;
+		for (size_t j = i + 1; j < tree.size(); j += lowestBit(j)) {
+			tree[j] += delta;
+		}
+	}
+
+	// Sum of the first k values
+	T prefix(int k) const
+	{
+		T sum = T();
+		for (size_t j = k; j > 0; j -= lowestBit(j)) {
+			sum += tree[j];
+		}
+		return sum;
+	}
+
+	T total() const { return prefix(values.size()); }
+
+	// Index of the value in which the running total reaches sum (the largest k with prefix(k) <= sum,
+	// kept within the list), and what is left of sum inside that value
+	int find(T sum, T& remainder) const
+	{
+		size_t position = 0;
+		for (size_t step = highestStep; step > 0 && !values.empty(); step /= 2) {
+			if (position + step < tree.size() && tree[position + step] <= sum) {
+				position += step;
+				sum -= tree[position];
+			}
+		}
+
+		if (position >= values.size() && !values.empty()) {
+			position = values.size() - 1;
+			sum += values[position];
+		}
+		remainder = sum;
+		return position;
+	}
+private:
+	static size_t lowestBit(size_t i) { return i & (~i + 1); }
+
+	vector<T> values;
+	vector<T> tree;
+	size_t highestStep = 1;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Watches a few small files from a background thread. The thread sleeps on the OS change
+// notifications of their directories (inotify on Linux, change notification handles on Windows,
+// a 250 ms poll elsewhere) and then compares the contents, so a save that changes nothing, or a
+// change to another file of the directory, is not reported. Editors often write a file in several
+// steps, so a change is only handed out once the files have been quiet for a short while.
+// Files can be added while the thread runs; a new directory is watched from its next wake-up.
+class FileWatcher
+{
+public:
+	FileWatcher() {}
+	~FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+	void watch(const string& path);
+	void start();
+	void stop();
+	bool takeChanges(vector<string>& changed, chrono::steady_clock::time_point& firstChange);
+private:
+	void run();
+	void checkFiles();
+	vector<string> takeNewDirectories();
+	static size_t hashFile(const string& path);
+
+	thread watcher;
+	mutex lock;
+	bool stopping = false;
+	unordered_map<string, size_t> fileHashes;
+	set<string> directories;
+	// Not yet handed to the OS notifications by the thread
+	vector<string> newDirectories;
+	vector<string> changedFiles;
+	chrono::steady_clock::time_point firstChange;
+	chrono::steady_clock::time_point lastChange;
+};
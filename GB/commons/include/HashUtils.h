@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+// 64-bit content hash used to key the on-disk caches. It consumes 8 bytes per step, so hashing
+// a memory-mapped asset costs little more than reading it; it is not meant to be cryptographic.
+inline unsigned long long hashBytes(const void* data, size_t size, unsigned long long seed = 0)
+{
+	const unsigned long long PRIME = 0x9E3779B97F4A7C15ULL;
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned long long h = seed ^ (size * PRIME);
+
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		unsigned long long word;
+		memcpy(&word, bytes + i, 8);
+		h = (h ^ word) * PRIME;
+		h ^= h >> 32;
+	}
+
+	for (; i < size; i++) {
+		h = (h ^ bytes[i]) * PRIME;
+	}
+
+	h ^= h >> 29;
+	h *= PRIME;
+	h ^= h >> 32;
+
+	return h;
+}
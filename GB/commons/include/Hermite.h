@@ -5,6 +5,6 @@ class Hermite :
 {
 public:
     Hermite();
-    void generateCurve(int pointsPerSegment);
+protected:
+    glm::mat4x3 getGeometry(int first) const;
 };
-
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+// Read-only view of a whole file mapped into memory (MapViewOfFile on Windows, mmap elsewhere).
+// The mapping lives until close() or the destructor, so pointers into getData() must not outlive it.
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	bool open(const string& filename);
+	void close();
+	bool isOpen() const { return opened; }
+	const char* getData() const { return data; }
+	const char* getEnd() const { return data + size; }
+	size_t getSize() const { return size; }
+private:
+	const char* data = nullptr;
+	size_t size = 0;
+	bool opened = false;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int fd = -1;
+#endif
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+//GLAD
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Surface properties of one MTL material, parsed once at load time
+struct Material {
+	string name;
+	glm::vec3 ka = glm::vec3(0.0f);
+	glm::vec3 kd = glm::vec3(1.5f);
+	glm::vec3 ks = glm::vec3(0.0f);
+	float ns = 0.0f;
+	float ni = 1.0f;
+	float d = 1.0f;
+	int illum = 2;
+	string mapKd;
+	string mapKs;
+	GLuint texKd = 0;
+	GLuint texKs = 0;
+	// Layer of texKd when it is a GL_TEXTURE_2D_ARRAY (see TextureArrays), -1 for a plain 2D texture
+	int layer = -1;
+	// Scale (xy) and offset (zw) applied to the UVs when mapKd was packed into an atlas page
+	glm::vec4 uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+};
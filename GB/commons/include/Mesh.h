@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+using namespace std;
+
+// Which optional streams and encodings a packed vertex uses
+struct VertexFormat {
+	// RGBA8 color stream, only for materials that read vertex colors
+	static const unsigned int COLOR = 1;
+	// UVs as half floats, for meshes whose UVs leave [0, 1] and cannot be stored as UNORM
+	static const unsigned int HALF_UV = 2;
+
+	unsigned int flags = 0;
+	int getStride() const { return 3 * sizeof(GLfloat) + 2 * sizeof(GLshort) + 2 * sizeof(GLushort) + ((flags & COLOR) ? 4 : 0); }
+};
+
+// Packed vertex and index blobs, ready for glBufferData or for the mesh cache
+struct MeshData {
+	VertexFormat format;
+	vector<unsigned char> vertexData;
+	vector<unsigned char> indexData;
+	int nbVertices = 0;
+	int nbIndices = 0;
+	GLenum indexType = GL_UNSIGNED_SHORT;
+	float boundsMin[3] = { 0, 0, 0 };
+	float boundsMax[3] = { 0, 0, 0 };
+};
+
+// Indexed triangle mesh on the GPU: one interleaved VBO plus an element buffer, stored with 16-bit indices
+// whenever the vertex count allows it. Vertices are packed to 20 bytes: float position, octahedral normal
+// in 2x16-bit SNORM, UV in 2x16-bit UNORM (or half floats), and an optional RGBA8 color (24 bytes).
+class Mesh
+{
+public:
+	// Identifies the packing done by pack(), so data prepared for another layout can be rejected
+	static const unsigned int VERTEX_LAYOUT = 2;
+
+	Mesh() {}
+	inline void setName(const string& name) { this->name = name; }
+	const string& getName() const { return name; }
+	static MeshData pack(const vector<float>& vertices, const vector<unsigned int>& indices);
+	void upload(const MeshData& data);
+	void upload(const VertexFormat& format, const void* vertexData, int nbVertices, const void* indexData, int nbIndices, GLenum indexType);
+	static GLenum chooseIndexType(int nbVertices) { return nbVertices <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+	static unsigned int getMaxIndex(const void* indexData, int nbIndices, GLenum indexType);
+	void draw();
+	void destroy();
+	GLuint getVAO() const { return VAO; }
+	int getNbVertices() const { return nbVertices; }
+	int getNbIndices() const { return nbIndices; }
+	GLenum getIndexType() const { return indexType; }
+protected:
+	GLuint VAO = 0, VBO = 0, EBO = 0;
+	int nbVertices = 0;
+	int nbIndices = 0;
+	GLenum indexType = GL_UNSIGNED_INT;
+	string name;
+};
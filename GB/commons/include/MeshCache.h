@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+
+using namespace std;
+
+// Header of a binary mesh cache file, followed by the raw vertex blob and the raw index blob
+struct MeshCacheHeader {
+	char magic[4];
+	unsigned int version;
+	unsigned long long sourceHash;
+	unsigned long long sourceSize;
+	unsigned long long sourceTime;
+	unsigned int vertexLayout;
+	unsigned int vertexFlags;
+	unsigned int vertexStride;
+	unsigned int nbVertices;
+	unsigned int nbIndices;
+	unsigned int indexSize;
+	float boundsMin[3];
+	float boundsMax[3];
+	unsigned long long vertexOffset;
+	unsigned long long indexOffset;
+};
+
+// Binary copy of a parsed OBJ kept next to it (<file>.meshcache), keyed by a hash of the OBJ contents.
+// load() memory-maps a valid cache and uploads straight from the mapping; a missing, stale or corrupt
+// cache makes it return false so the caller falls back to the text parser and then calls store().
+// The size and write time of the OBJ are checked first, so an unchanged file is never read: it is
+// only hashed when its time differs (a copy or a checkout), and a matching hash then refreshes the
+// time stored in the cache.
+class MeshCache
+{
+public:
+	static const unsigned int VERSION = 3;
+
+	MeshCache() {}
+	bool load(const string& sourceFilename, Mesh& mesh);
+	bool store(const MeshData& data);
+	static string getCachePath(const string& sourceFilename) { return sourceFilename + ".meshcache"; }
+private:
+	bool hashSource();
+	void refreshTime(MeshCacheHeader header) const;
+
+	string sourceFilename;
+	unsigned long long sourceHash = 0;
+	unsigned long long sourceSize = 0;
+	unsigned long long sourceTime = 0;
+	bool hasSource = false;
+	bool hashed = false;
+};
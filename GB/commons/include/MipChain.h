@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// One level of a mip chain: tightly packed RGBA8 rows, or 4x4 blocks once compressed
+struct MipLevel {
+	int width;
+	int height;
+	vector<unsigned char> data;
+};
+
+// Header of a baked texture file. Like KTX2 it is followed by a level index (one MipLevelIndex per
+// level, largest first), and each level's data sits at the offset given there.
+struct MipCacheHeader {
+	char magic[4];
+	unsigned int version;
+	unsigned long long sourceHash;
+	unsigned long long sourceSize;
+	unsigned int width;
+	unsigned int height;
+	unsigned int nbLevels;
+	unsigned int srgb;
+	unsigned int format;
+	unsigned int reserved;
+};
+
+struct MipLevelIndex {
+	unsigned long long offset;
+	unsigned long long size;
+};
+
+// Full mip chain built on the CPU with a 2x2 box filter, 3 taps wide along an odd dimension so no
+// row or column is dropped (SSE2, four texels at a time, when available). Color data is
+// averaged in linear space and converted back, so sRGB textures do not darken as they shrink.
+// compress() turns every level into BC1 (opaque images) or BC3 (images with alpha).
+// The chain is baked next to the image (<file>.mips), keyed by a hash of the image file, so later
+// loads skip the decode, the filtering and the compression.
+class MipChain
+{
+public:
+	static const unsigned int VERSION = 3;
+
+	// Level data formats
+	static const unsigned int RGBA8 = 0;
+	static const unsigned int BC1 = 1;
+	static const unsigned int BC3 = 2;
+
+	MipChain() {}
+	void build(const unsigned char* pixels, int width, int height, bool srgb);
+	void compress();
+	bool load(const string& filename, unsigned long long sourceHash, unsigned long long sourceSize, bool srgb, bool compressed);
+	bool store(const string& filename, unsigned long long sourceHash, unsigned long long sourceSize) const;
+	bool loadImage(const string& imageFilename, unsigned long long sourceHash, unsigned long long sourceSize, bool srgb, bool compressed);
+	static bool bake(const string& imageFilename, bool srgb, bool compressed);
+	static string getCachePath(const string& imageFilename) { return imageFilename + ".mips"; }
+	const vector<MipLevel>& getLevels() const { return levels; }
+	unsigned int getFormat() const { return format; }
+	size_t getSize() const;
+	bool isEmpty() const { return levels.empty(); }
+private:
+	vector<MipLevel> levels;
+	bool srgb = false;
+	unsigned int format = RGBA8;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+// Measures OBJ parsing throughput (MB/s and triangles/s) of the ObjReader, serial and threaded, against the original
+// getline/split/stof loader, which is kept here only as the reference implementation.
+class ObjBenchmark
+{
+public:
+	ObjBenchmark(int iterations) : iterations(iterations) {}
+	void run(const string& filename);
+private:
+	int iterations;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+
+using namespace std;
+
+struct ObjChunk;
+struct VertexKey;
+
+// Wavefront OBJ reader that memory-maps the file and tokenizes it in place, without allocating per line.
+// Produces an indexed mesh: one vertex per distinct (v, vt, vn) triple, as 3 position + 2 texcoord + 3 normal
+// floats (the input of Mesh::pack), and three indices per triangle.
+// With a thread pool set, the file is split at line boundaries and the chunks are parsed in parallel;
+// the merge is done in file order, so the output is identical to the single-threaded one.
+class ObjReader
+{
+public:
+	static const int FLOATS_PER_VERTEX = 8;
+
+	ObjReader() {}
+	inline void setThreadPool(ThreadPool* pool) { this->pool = pool; }
+	bool read(const string& filename);
+	void parse(const char* begin, const char* end);
+	const vector<float>& getVertices() const { return vertices; }
+	const vector<unsigned int>& getIndices() const { return indices; }
+	int getNbVertices() const { return vertices.size() / FLOATS_PER_VERTEX; }
+	int getNbTriangles() const { return indices.size() / 3; }
+protected:
+	void runTasks(int nbTasks, const function<void(int)>& task);
+	void resolveChunk(const ObjChunk& chunk, vector<VertexKey>& keys);
+	void buildVertices(const vector<VertexKey>& keys);
+	vector<float> positions;
+	vector<float> texCoords;
+	vector<float> normals;
+	vector<float> vertices;
+	vector<unsigned int> indices;
+	ThreadPool* pool = nullptr;
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <istream>
+#include <string>
+
+using namespace std;
+
+// Non-allocating number parsing in the style of std::from_chars: each function reads from [first, last),
+// stores the value and returns a pointer past the last consumed character (or first if nothing was parsed).
+// Used by the text asset readers so they can tokenize a memory-mapped buffer in place.
+
+inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* first, const char* last)
+{
+	while (first < last && isBlank(*first)) {
+		first++;
+	}
+	return first;
+}
+
+inline const char* findLineEnd(const char* first, const char* last)
+{
+	while (first < last && *first != '\n') {
+		first++;
+	}
+	return first;
+}
+
+// Rest of a statement after its keyword, trimmed, so MTL map paths may contain spaces
+inline string readRest(istream& row)
+{
+	string rest;
+	getline(row >> ws, rest);
+	rest.erase(rest.find_last_not_of(" \t\r") + 1);
+	return rest;
+}
+
+inline const char* parseInt(const char* first, const char* last, int& value)
+{
+	const char* p = first;
+	bool negative = false;
+
+	if (p < last && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+
+	const char* digits = p;
+	int result = 0;
+	while (p < last && *p >= '0' && *p <= '9') {
+		result = result * 10 + (*p - '0');
+		p++;
+	}
+
+	if (p == digits) {
+		return first;
+	}
+
+	value = negative ? -result : result;
+	return p;
+}
+
+inline const char* parseFloat(const char* first, const char* last, float& value)
+{
+	// Powers of ten up to 1e22 are exact in a double, so a single multiply/divide rounds correctly
+	static const double powersOf10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const char* p = first;
+	bool negative = false;
+
+	if (p < last && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+
+	unsigned long long mantissa = 0;
+	int exponent = 0, nbDigits = 0, nbSignificant = 0;
+
+	while (p < last && *p >= '0' && *p <= '9') {
+		if (nbSignificant < 19) {
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa != 0) {
+				nbSignificant++;
+			}
+		}
+		else {
+			exponent++;
+		}
+		nbDigits++;
+		p++;
+	}
+
+	if (p < last && *p == '.') {
+		p++;
+		while (p < last && *p >= '0' && *p <= '9') {
+			if (nbSignificant < 19) {
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa != 0) {
+					nbSignificant++;
+				}
+				exponent--;
+			}
+			nbDigits++;
+			p++;
+		}
+	}
+
+	if (nbDigits == 0) {
+		return first;
+	}
+
+	if (p < last && (*p == 'e' || *p == 'E')) {
+		int exponentValue = 0;
+		const char* end = parseInt(p + 1, last, exponentValue);
+		if (end != p + 1) {
+			exponent += exponentValue;
+			p = end;
+		}
+	}
+
+	double result = (double)mantissa;
+	if (mantissa != 0) {
+		while (exponent > 22) {
+			result *= 1e22;
+			exponent -= 22;
+		}
+		while (exponent < -22) {
+			result /= 1e22;
+			exponent += 22;
+		}
+		result = exponent < 0 ? result / powersOf10[-exponent] : result * powersOf10[exponent];
+	}
+
+	value = (float)(negative ? -result : result);
+	return p;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Mesh.h"
+#include "Material.h"
+
+using namespace std;
+
+// Light slots of the FrameData block, the shaders light the first NUM_LIGHTS of them
+static const int MAX_LIGHTS = 4;
+
+// std140 layout of the FrameData block in common.glsl
+struct FrameUniforms {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec4 cameraPos;
+	glm::vec4 lightPos[MAX_LIGHTS];
+	glm::vec4 lightColor[MAX_LIGHTS];
+};
+
+// std140 layout of the MaterialData block in common.glsl
+struct MaterialUniforms {
+	glm::vec4 ka;
+	glm::vec4 kd;
+	glm::vec4 ks;
+	float q;
+	float ni;
+	float d;
+	int layer;
+	glm::vec4 uvTransform;
+};
+
+// Collects the draws of a frame and submits them sorted by (program, material, texture, VAO), so a bind
+// is only issued when that state actually changes. Per-frame data lives in one uniform buffer and all
+// materials share a second one, each material at its own aligned offset.
+class Renderer
+{
+public:
+	static const GLuint FRAME_BINDING = 0;
+	static const GLuint MATERIAL_BINDING = 1;
+	// Array textures go to their own unit, so a sampler2D and a sampler2DArray never share one
+	static const GLuint ARRAY_TEXTURE_UNIT = 1;
+
+	Renderer() {}
+	void init();
+	void destroy();
+	int addMaterial(const Material& material);
+	void uploadMaterials();
+	void beginFrame(const FrameUniforms& frame);
+	void submit(Shader* shader, int material, const Mesh& mesh, const glm::mat4& model);
+	void flush();
+	int getNbDraws() const { return nbDraws; }
+	int getNbSkippedBinds() const { return nbSkippedBinds; }
+protected:
+	// Resolved per program, so a shader that was reloaded in place gets its location again
+	struct ModelUniform {
+		GLuint program;
+		Mat4Uniform handle;
+	};
+
+	struct DrawItem {
+		unsigned long long key;
+		Shader* shader;
+		int material;
+		GLuint texture;
+		GLenum target;
+		const Mesh* mesh;
+		glm::mat4 model;
+	};
+
+	GLuint frameUBO = 0, materialUBO = 0;
+	GLsizeiptr materialStride = 0;
+	vector<MaterialUniforms> materialData;
+	vector<GLuint> materialTextures;
+	vector<GLenum> materialTargets;
+	vector<DrawItem> draws;
+	map<Shader*, ModelUniform> modelUniforms;
+	int nbDraws = 0;
+	int nbSkippedBinds = 0;
+};
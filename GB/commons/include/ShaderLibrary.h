@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Shader.h"
+#include "Material.h"
+#include "FileWatcher.h"
+
+using namespace std;
+
+// One uber shader (vertex + fragment file pair) compiled into variants. Each feature bit becomes a
+// #define inserted after the #version line, so a material without a texture or specular term gets a
+// program that does not do that work. Sources may #include other files, resolved relative to the
+// including file and pasted once. All requested variants are compiled in one go: every compile is
+// submitted before any status is read, which lets drivers with KHR_parallel_shader_compile (or
+// background compilation) build them side by side.
+// With hot reload on, a change to any of the source files rebuilds every variant while the old
+// programs keep drawing. update() swaps the new programs in at the start of a frame, all at once,
+// and only if every one of them compiled and linked; otherwise the errors are printed and the
+// old programs stay. The rebuild runs on a thread of its own, with a hidden window whose context
+// shares objects with the viewer's, so even a driver that compiles inside glLinkProgram or the
+// status queries never holds up a frame. A fence set after the last link tells update() when the
+// programs can be used from the render context. Every rebuild collects the includes again, so a
+// file included since the start is watched as well.
+class ShaderLibrary
+{
+public:
+	// Feature bits, also the names of the defines
+	static const unsigned int TEXTURED = 1;
+	static const unsigned int VERTEX_COLOR = 2;
+	static const unsigned int SPECULAR = 4;
+
+	ShaderLibrary(const string& vertexPath, const string& fragmentPath) : vertexPath(vertexPath), fragmentPath(fragmentPath) {}
+	inline void setNbLights(int nbLights) { this->nbLights = nbLights; }
+	void build(const vector<unsigned int>& featureSets);
+	Shader* get(unsigned int features);
+	void destroy();
+	// window is the one whose context draws with the programs
+	void enableHotReload(GLFWwindow* window);
+	void update();
+	int getNbVariants() const { return variants.size(); }
+	int getAvoidedLookups() const;
+	void resetAvoidedLookups();
+	static unsigned int getFeatures(const Material& material, bool vertexColor);
+	static string preprocess(const string& filename, const string& defines, set<string>* files = NULL);
+private:
+	static bool appendFile(const string& filename, string& out, set<string>& included, bool topLevel, const string& defines);
+	string getDefines(unsigned int features) const;
+	void compileReloads();
+	bool takeReloads(bool& valid);
+	void watchSources(const set<string>& files);
+
+	string vertexPath;
+	string fragmentPath;
+	int nbLights = 1;
+	map<unsigned int, unique_ptr<Shader>> variants;
+	set<string> sourceFiles;
+
+	FileWatcher watcher;
+	map<unsigned int, unique_ptr<Shader>> reloading;
+	chrono::steady_clock::time_point changeTime;
+	chrono::steady_clock::time_point reloadStart;
+
+	// Reload thread: it owns reloading from the request until the fence is set
+	GLFWwindow* compilerWindow = NULL;
+	thread compiler;
+	mutex lock;
+	condition_variable wake;
+	bool stopping = false;
+	bool compileRequested = false;
+	bool reloadValid = false;
+	// Files the reload was made of, includes too
+	set<string> reloadFiles;
+	GLsync reloadFence = 0;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Array texture holding an image, and the layer it sits in
+struct TextureLayer {
+	GLuint array = 0;
+	int layer = -1;
+};
+
+// Groups textures of equal size, format and mip count into GL_TEXTURE_2D_ARRAY layers, so draws that
+// sample different images can share one texture binding and only differ by the layer index, which
+// travels in the material block. Unlike TextureLoader everything is decoded (on the thread pool) and
+// uploaded at once in build(), since an array's storage must hold all of its layers.
+class TextureArrays
+{
+public:
+	TextureArrays() {}
+	inline void setThreadPool(ThreadPool* pool) { this->pool = pool; }
+	inline void setAnisotropy(float anisotropy) { this->anisotropy = anisotropy; }
+	inline void setCompression(bool compression) { this->compression = compression; }
+	void add(const string& path);
+	void build();
+	void destroy();
+	TextureLayer find(const string& path) const;
+	int getNbArrays() const { return arrays.size(); }
+	int getNbLayers() const { return layers.size(); }
+private:
+	ThreadPool* pool = nullptr;
+	float anisotropy = 1.0f;
+	bool compression = true;
+	vector<string> paths;
+	vector<GLuint> arrays;
+	unordered_map<string, TextureLayer> layers;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+using namespace std;
+
+// Where one source image ended up: its page and the scale/offset that maps its [0, 1] UVs into that page
+struct AtlasEntry {
+	int page = 0;
+	int x = 0, y = 0;
+	int width = 0, height = 0;
+	glm::vec4 uvTransform = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+};
+
+// Packs small textures into a few square pages offline, so materials that used to bind a texture each
+// can share one. Rectangles are placed with a skyline bottom-left packer; every image gets a gutter
+// filled with its own edge texels, so filtering and the first mip levels do not bleed in neighbours.
+// build() writes the pages as .tga files plus a text manifest, which load() reads back at run time.
+// Only images sampled inside [0, 1] can be atlased: repeating UVs would wrap onto other images.
+class TextureAtlas
+{
+public:
+	TextureAtlas(int pageSize = 2048, int padding = 4) : pageSize(pageSize), padding(padding) {}
+	void addImage(const string& path);
+	void addMtl(const string& filename);
+	bool build(const string& name);
+	bool load(const string& manifestFilename);
+	const AtlasEntry* find(const string& path) const;
+	const string& getPageFile(int page) const { return pageFiles[page]; }
+	int getNbPages() const { return pageFiles.size(); }
+private:
+	struct SkylineNode {
+		int x, y, width;
+	};
+
+	bool findPosition(const vector<SkylineNode>& skyline, int width, int height, int& bestIndex, int& bestX, int& bestY) const;
+	void addLevel(vector<SkylineNode>& skyline, int index, int x, int y, int width, int height);
+	static bool writeTga(const string& filename, const vector<unsigned char>& pixels, int width, int height);
+
+	int pageSize;
+	int padding;
+	vector<string> sources;
+	map<string, AtlasEntry> entries;
+	vector<string> pageFiles;
+};
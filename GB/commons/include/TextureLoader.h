@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+//GLAD
+#include <glad/glad.h>
+
+#include "ThreadPool.h"
+#include "MipChain.h"
+
+using namespace std;
+
+// Streams textures in the background: load() returns a texture name at once, filled with a 1x1
+// placeholder, and queues the image decode on the thread pool. The worker also builds the mip chain
+// (or reads the baked one, see MipChain). update() runs on the GL thread once per frame and uploads
+// finished chains until the per-frame byte budget is spent. A chain is sent smallest level first,
+// and a level larger than what is left of the budget goes up in bands of rows over several frames;
+// GL_TEXTURE_BASE_LEVEL follows the finished levels, so the texture sharpens as they arrive and
+// never samples a partial one. At least one band is sent per frame, so a tiny budget still makes
+// progress. Textures are sampled trilinearly, with anisotropic
+// filtering when the driver supports it. Chains are block compressed (BC1/BC3) unless compression
+// is turned off or the driver lacks S3TC.
+// Textures are shared: a path already loaded, or another file with the same contents, returns the
+// existing texture and bumps its reference count; release() deletes it when the count drops to zero.
+class TextureLoader
+{
+public:
+	TextureLoader() {}
+	~TextureLoader();
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+	inline void setThreadPool(ThreadPool* pool) { this->pool = pool; }
+	inline void setUploadBudget(size_t bytesPerFrame) { this->uploadBudget = bytesPerFrame; }
+	inline void setMaxAnisotropy(float maxAnisotropy) { this->maxAnisotropy = maxAnisotropy; }
+	inline void setCompression(bool compression) { this->compression = compression; }
+	GLuint load(const string& path);
+	void release(GLuint texture);
+	void update();
+	// What the driver supports, for textures created outside the loader
+	float getAnisotropy() { queryDriverSupport(); return anisotropy; }
+	bool getCompression() { queryDriverSupport(); return compression && s3tcSupported; }
+	int getNbPending() const { return nbPending; }
+	int getNbHits() const { return nbHits; }
+	int getNbMisses() const { return nbMisses; }
+	size_t getResidentBytes() const { return residentBytes; }
+private:
+	struct DecodedImage {
+		GLuint texture;
+		string path;
+		MipChain mips;
+		// Upload progress: the level being sent (the smallest first) and its next row of blocks (or of texels)
+		int level;
+		int nextRow;
+	};
+
+	struct CachedTexture {
+		int refCount;
+		string path;
+		unsigned long long hash;
+		size_t fileSize;
+		size_t bytes;
+	};
+
+	GLuint createTexture(const string& path, unsigned long long hash, size_t fileSize);
+	void decode(GLuint texture, const string& path, unsigned long long hash, size_t fileSize, bool compressed);
+	void queryDriverSupport();
+	bool startUpload(DecodedImage& image);
+	size_t uploadRows(DecodedImage& image, size_t budget, bool first);
+
+	ThreadPool* pool = nullptr;
+	size_t uploadBudget = 4 * 1024 * 1024;
+	float maxAnisotropy = 8.0f;
+	bool compression = true;
+	bool driverQueried = false;
+	float anisotropy = 1.0f;
+	bool s3tcSupported = false;
+	int nbPending = 0;
+	int nbHits = 0;
+	int nbMisses = 0;
+	size_t residentBytes = 0;
+
+	unordered_map<GLuint, CachedTexture> cache;
+	unordered_map<string, GLuint> texturesByPath;
+	unordered_map<unsigned long long, GLuint> texturesByHash;
+
+	// The chain being uploaded, over as many frames as the budget needs; only touched by update()
+	DecodedImage uploading;
+	bool isUploading = false;
+
+	mutex lock;
+	condition_variable decodeDone;
+	deque<DecodedImage> decoded;
+	int nbDecoding = 0;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Fixed set of worker threads. parallelFor() splits a job into numbered tasks and blocks
+// until all of them are done; the calling thread takes tasks too. enqueue() hands a task to
+// the workers without waiting; parallelFor() jobs are served first. Each parallelFor() call
+// has a job of its own, so it can be called from several threads at once, and from inside a
+// task: the caller runs its own tasks, so it never waits on a task nobody has started.
+class ThreadPool
+{
+public:
+	ThreadPool(int nbThreads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	void parallelFor(int count, const function<void(int)>& task);
+	void enqueue(const function<void()>& task);
+	int getNbThreads() const { return workers.size() + 1; }
+private:
+	struct Job {
+		const function<void(int)>* task;
+		int nextTask;
+		int nbTasks;
+		int nbPending;
+	};
+
+	void workerLoop();
+	bool runNextTask(Job& job, unique_lock<mutex>& guard);
+	vector<thread> workers;
+	mutex lock;
+	condition_variable wakeWorkers;
+	condition_variable jobDone;
+	// Jobs with tasks not handed out yet, oldest first; each lives on the stack of its parallelFor()
+	deque<Job*> jobs;
+	deque<function<void()>> backgroundTasks;
+	bool stopping = false;
+};
@@ -0,0 +1,12 @@
+#include "BSpline.h"
+
+BSpline::BSpline()
+{
+	M = glm::mat4(-1, 3, -3, 1,
+		3, -6, 3, 0,
+		-3, 0, 3, 0,
+		1, 4, 1, 0
+	) / 6.0f;
+	stride = 1;
+	name = "B-spline curve";
+}
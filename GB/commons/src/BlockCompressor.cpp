@@ -0,0 +1,183 @@
+#include "BlockCompressor.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+static void fetchBlock(const unsigned char* rgba, int width, int height, int blockX, int blockY, unsigned char block[16][4])
+{
+	for (int y = 0; y < 4; y++) {
+		int sourceY = min(blockY * 4 + y, height - 1);
+		for (int x = 0; x < 4; x++) {
+			int sourceX = min(blockX * 4 + x, width - 1);
+			memcpy(block[y * 4 + x], rgba + ((size_t)sourceY * width + sourceX) * 4, 4);
+		}
+	}
+}
+
+static unsigned short packRGB565(const float color[3])
+{
+	int r = (int)(min(max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+	int g = (int)(min(max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+	int b = (int)(min(max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+	return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+static void unpackRGB565(unsigned short color, int out[3])
+{
+	int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+	out[0] = (r << 3) | (r >> 2);
+	out[1] = (g << 2) | (g >> 4);
+	out[2] = (b << 3) | (b >> 2);
+}
+
+// Four-color BC1 block: endpoints at the extremes of the colors projected on their principal axis
+static void encodeColorBlock(const unsigned char block[16][4], unsigned char* out)
+{
+	float mean[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			mean[c] += block[i][c] / 16.0f;
+		}
+	}
+
+	float covariance[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+		covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+		covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+	}
+
+	// A few power iterations are enough to find the dominant axis of a 4x4 block
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 4; iteration++) {
+		float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+		float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+		float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+		float length = max(max(fabs(x), fabs(y)), fabs(z));
+		if (length < 1e-6f) {
+			break;
+		}
+		axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+	}
+	float axisLength = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+	float minProjection = 0.0f, maxProjection = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		float projection = ((block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2]) / axisLength;
+		minProjection = min(minProjection, projection);
+		maxProjection = max(maxProjection, projection);
+	}
+
+	float maxColor[3], minColor[3];
+	for (int c = 0; c < 3; c++) {
+		maxColor[c] = mean[c] + axis[c] * maxProjection;
+		minColor[c] = mean[c] + axis[c] * minProjection;
+	}
+
+	unsigned short color0 = packRGB565(maxColor);
+	unsigned short color1 = packRGB565(minColor);
+	unsigned int indices = 0;
+
+	// color0 > color1 selects the four-color mode; equal endpoints leave every index at 0
+	if (color0 < color1) {
+		swap(color0, color1);
+	}
+
+	if (color0 != color1) {
+		int palette[4][3];
+		unpackRGB565(color0, palette[0]);
+		unpackRGB565(color1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (int i = 0; i < 16; i++) {
+			int best = 0, bestDistance = INT_MAX;
+			for (int p = 0; p < 4; p++) {
+				int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (unsigned int)best << (2 * i);
+		}
+	}
+
+	out[0] = color0 & 0xFF; out[1] = color0 >> 8;
+	out[2] = color1 & 0xFF; out[3] = color1 >> 8;
+	for (int k = 0; k < 4; k++) {
+		out[4 + k] = (indices >> (8 * k)) & 0xFF;
+	}
+}
+
+// Eight-value BC3 alpha block between the block's min and max alpha
+static void encodeAlphaBlock(const unsigned char block[16][4], unsigned char* out)
+{
+	int alpha0 = 0, alpha1 = 255;
+	for (int i = 0; i < 16; i++) {
+		alpha0 = max(alpha0, (int)block[i][3]);
+		alpha1 = min(alpha1, (int)block[i][3]);
+	}
+
+	unsigned long long indices = 0;
+	if (alpha0 != alpha1) {
+		int palette[8] = { alpha0, alpha1 };
+		for (int p = 1; p < 7; p++) {
+			palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+		}
+
+		for (int i = 0; i < 16; i++) {
+			int best = 0, bestDistance = INT_MAX;
+			for (int p = 0; p < 8; p++) {
+				int distance = abs(block[i][3] - palette[p]);
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (unsigned long long)best << (3 * i);
+		}
+	}
+
+	out[0] = (unsigned char)alpha0;
+	out[1] = (unsigned char)alpha1;
+	for (int k = 0; k < 6; k++) {
+		out[2 + k] = (indices >> (8 * k)) & 0xFF;
+	}
+}
+
+void BlockCompressor::compressBC1(const unsigned char* rgba, int width, int height, vector<unsigned char>& out)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	out.resize(getCompressedSize(width, height, 8));
+
+	unsigned char block[16][4];
+	for (int y = 0; y < blocksY; y++) {
+		for (int x = 0; x < blocksX; x++) {
+			fetchBlock(rgba, width, height, x, y, block);
+			encodeColorBlock(block, &out[((size_t)y * blocksX + x) * 8]);
+		}
+	}
+}
+
+void BlockCompressor::compressBC3(const unsigned char* rgba, int width, int height, vector<unsigned char>& out)
+{
+	int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	out.resize(getCompressedSize(width, height, 16));
+
+	unsigned char block[16][4];
+	for (int y = 0; y < blocksY; y++) {
+		for (int x = 0; x < blocksX; x++) {
+			fetchBlock(rgba, width, height, x, y, block);
+			unsigned char* blockOut = &out[((size_t)y * blocksX + x) * 16];
+			encodeAlphaBlock(block, blockOut);
+			encodeColorBlock(block, blockOut + 8);
+		}
+	}
+}
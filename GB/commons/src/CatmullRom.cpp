@@ -0,0 +1,57 @@
+#include "CatmullRom.h"
+
+#include <cmath>
+
+CatmullRom::CatmullRom(float alpha) : alpha(alpha)
+{
+	if (alpha == 0.0f) {
+		M = glm::mat4(-1, 3, -3, 1,
+			2, -5, 4, -1,
+			-1, 0, 1, 0,
+			0, 2, 0, 0
+		) * 0.5f;
+	}
+	else {
+		// Non-uniform knots do not fit a single basis matrix, so segments go through the Hermite
+		// basis with the tangents of the knot spacing
+		M = glm::mat4(2, -2, 1, 1,
+			-3, 3, -2, -1,
+			0, 0, 1, 0,
+			1, 0, 0, 0
+		);
+	}
+	stride = 1;
+	name = "Catmull-Rom curve";
+}
+
+glm::mat4x3 CatmullRom::getGeometry(int first) const
+{
+	if (alpha == 0.0f) {
+		return Curve::getGeometry(first);
+	}
+
+	glm::vec3 P0 = controlPoints[first];
+	glm::vec3 P1 = controlPoints[first + 1];
+	glm::vec3 P2 = controlPoints[first + 2];
+	glm::vec3 P3 = controlPoints[first + 3];
+
+	// Knot intervals |Pi+1 - Pi|^alpha; a repeated point takes the interval of the middle span
+	float d0 = pow(glm::distance(P0, P1), alpha);
+	float d1 = pow(glm::distance(P1, P2), alpha);
+	float d2 = pow(glm::distance(P2, P3), alpha);
+	if (d1 < 1e-4f) {
+		d1 = 1.0f;
+	}
+	if (d0 < 1e-4f) {
+		d0 = d1;
+	}
+	if (d2 < 1e-4f) {
+		d2 = d1;
+	}
+
+	// Tangents at P1 and P2, scaled to the [0, 1] parameter of the middle span
+	glm::vec3 T1 = (P2 - P1) + d1 * ((P1 - P0) / d0 - (P2 - P0) / (d0 + d1));
+	glm::vec3 T2 = (P2 - P1) + d1 * ((P3 - P2) / d2 - (P3 - P1) / (d1 + d2));
+
+	return glm::mat4x3(P1, P2, T1, T2);
+}
@@ -1,4 +1,8 @@
 #include "Curve.h"
+#include "CurveEvaluator.h"
+
+#include <algorithm>
+#include <cmath>
 
 void Curve::setShader(Shader* shader)
 {
@@ -6,15 +10,386 @@ void Curve::setShader(Shader* shader)
 	shader->Use();
 }
 
+glm::mat4x3 Curve::getGeometry(int first) const
+{
+	return glm::mat4x3(controlPoints[first], controlPoints[first + 1], controlPoints[first + 2], controlPoints[first + 3]);
+}
+
+int Curve::getNbSegments() const
+{
+	int nControlPoints = controlPoints.size();
+	return nControlPoints >= 4 ? (nControlPoints - 4) / stride + 1 : 0;
+}
+
+void Curve::generateCurve(int pointsPerSegment)
+{
+	this->pointsPerSegment = pointsPerSegment;
+	tolerance = 0.0f;
+	tessellate();
+}
+
+void Curve::generateCurveAdaptive(float tolerance)
+{
+	pointsPerSegment = 0;
+	this->tolerance = tolerance;
+	tessellate();
+}
+
+static int roundUpToPowerOfTwo(int n)
+{
+	int power = 1;
+	while (power < n) {
+		power *= 2;
+	}
+	return power;
+}
+
+// Every segment gets a slot of slotSize points in curvePoints and in the VBO, so an edit rewrites
+// its own slots and nothing else. With a fixed number of points per segment the slots are full;
+// adaptive segments get room to grow.
+void Curve::tessellate()
+{
+	int nSegments = getNbSegments();
+
+	// Room for t = 0, step, ..., 1 on every segment, evaluated straight into the buffer
+	vector<glm::vec3> points;
+	points.reserve(pointsPerSegment > 0 ? nSegments * (pointsPerSegment + 1) : 0);
+	vector<int> starts(nSegments + 1);
+
+	for (int k = 0; k < nSegments; k++)
+	{
+		starts[k] = points.size();
+		tessellateSegment(k, points);
+	}
+	starts[nSegments] = points.size();
+
+	int largest = 0;
+	for (int k = 0; k < nSegments; k++) {
+		largest = max(largest, starts[k + 1] - starts[k]);
+	}
+
+	segmentCounts.resize(nSegments);
+	for (int k = 0; k < nSegments; k++) {
+		segmentCounts[k] = starts[k + 1] - starts[k];
+	}
+
+	if (pointsPerSegment > 0) {
+		slotSize = largest;
+		curvePoints.swap(points);
+	}
+	else {
+		slotSize = roundUpToPowerOfTwo(largest);
+		curvePoints.assign(nSegments * slotSize, glm::vec3(0.0f));
+		for (int k = 0; k < nSegments; k++) {
+			copy(points.begin() + starts[k], points.begin() + starts[k + 1], curvePoints.begin() + k * slotSize);
+		}
+	}
+
+	slotFirsts.resize(nSegments);
+	arcLengths.assign(curvePoints.size(), 0.0f);
+	vector<float> lengths(nSegments);
+	vector<int> visible(nSegments);
+	vector<glm::mat4x3> segments(nSegments);
+	for (int k = 0; k < nSegments; k++)
+	{
+		slotFirsts[k] = k * slotSize;
+		lengths[k] = updateArcLengths(k);
+		visible[k] = getNbVisiblePoints(k);
+		segments[k] = getGeometry(k * stride) * M;
+	}
+	segmentLengths.assign(lengths);
+	segmentPoints.assign(visible);
+	bvh.build(segments);
+
+	uploadPoints(0, curvePoints.size());
+}
+
+// Each segment starts with its first point, which is also the last point of the previous one: every
+// slot is drawn as its own line strip
+void Curve::tessellateSegment(int k, vector<glm::vec3>& out) const
+{
+	glm::mat4x3 G = getGeometry(k * stride);
+
+	if (pointsPerSegment > 0) {
+		size_t first = out.size();
+		out.resize(first + pointsPerSegment + 1);
+		CurveEvaluator::evaluate(CurveEvaluator::makeSegment(G, M), pointsPerSegment + 1, 1.0f / (float)pointsPerSegment, &out[first]);
+		return;
+	}
+
+	// Any cubic segment, once in power form, has the Bezier control points d, d + c / 3,
+	// d + (2c + b) / 3 and a + b + c + d, which are then subdivided as is
+	glm::mat4x3 C = G * M;
+	glm::vec3 a = C[0], b = C[1], c = C[2], d = C[3];
+
+	out.push_back(d);
+	subdivide(d, d + c / 3.0f, d + (2.0f * c + b) / 3.0f, a + b + c + d, 0, out);
+}
+
+// Segment k uses the control points k * stride to k * stride + 3, so a point is in at most 4
+// segments (2 with a stride of 3), whatever the length of the curve
+void Curve::setControlPoint(int i, const glm::vec3& point)
+{
+	if (i < 0 || i >= (int)controlPoints.size()) {
+		return;
+	}
+
+	controlPoints[i] = point;
+
+	// Not generated yet, or generated from another set of control points
+	int nSegments = getNbSegments();
+	if ((int)segmentCounts.size() != nSegments) {
+		return;
+	}
+
+	int first = i < 3 ? 0 : (i - 3 + stride - 1) / stride;
+	int last = min(i / stride, nSegments - 1);
+	if (first <= last) {
+		updateSegments(first, last);
+	}
+}
+
+// Only the slots of the segments change, and only their points are sent to the buffer. A segment
+// that outgrows its slot makes all the slots twice as large, which is rare and is the only full copy.
+void Curve::updateSegments(int first, int last)
+{
+	vector<glm::vec3> points;
+	for (int k = first; k <= last; k++) {
+		points.clear();
+		tessellateSegment(k, points);
+
+		if ((int)points.size() > slotSize) {
+			resizeSlots(roundUpToPowerOfTwo(points.size()));
+		}
+
+		copy(points.begin(), points.end(), curvePoints.begin() + k * slotSize);
+		segmentCounts[k] = points.size();
+
+		segmentLengths.set(k, updateArcLengths(k));
+		segmentPoints.set(k, getNbVisiblePoints(k));
+		bvh.update(k, getGeometry(k * stride) * M);
+
+		uploadPoints(k * slotSize, points.size());
+	}
+}
+
+void Curve::resizeSlots(int size)
+{
+	int nSegments = segmentCounts.size();
+
+	vector<glm::vec3> points(nSegments * size, glm::vec3(0.0f));
+	vector<float> lengths(nSegments * size, 0.0f);
+	for (int k = 0; k < nSegments; k++) {
+		copy(curvePoints.begin() + k * slotSize, curvePoints.begin() + k * slotSize + segmentCounts[k], points.begin() + k * size);
+		copy(arcLengths.begin() + k * slotSize, arcLengths.begin() + k * slotSize + segmentCounts[k], lengths.begin() + k * size);
+		slotFirsts[k] = k * size;
+	}
+
+	curvePoints.swap(points);
+	arcLengths.swap(lengths);
+	slotSize = size;
+
+	uploadPoints(0, curvePoints.size());
+}
+
+// The first point of every segment but the first repeats the end of the previous one
+int Curve::getNbVisiblePoints(int k) const
+{
+	return k == 0 ? segmentCounts[k] : segmentCounts[k] - 1;
+}
+
+glm::vec3 Curve::getPointOnCurve(int i) const
+{
+	int j;
+	int k = segmentPoints.find(i, j);
+	return curvePoints[k * slotSize + (k == 0 ? j : j + 1)];
+}
+
+// Distance from p to the segment between a and b
+static float getDistanceToChord(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b)
+{
+	glm::vec3 chord = b - a;
+	float chordLength2 = glm::dot(chord, chord);
+	float t = chordLength2 > 0.0f ? glm::clamp(glm::dot(p - a, chord) / chordLength2, 0.0f, 1.0f) : 0.0f;
+	return glm::distance(p, a + chord * t);
+}
+
+// Largest distance of the inner control points from the chord, an upper bound of how far the
+// segment strays from the straight line between its ends. The chord is a segment, not a line:
+// inner points past its ends (a curve doubling back on itself) count too. The segment lies in the
+// hull of its control points, and no point of the hull is further from the chord than they are.
+static float getFlatness(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3)
+{
+	return max(getDistanceToChord(p1, p0, p3), getDistanceToChord(p2, p0, p3));
+}
+
+// de Casteljau split at t = 0.5 until each piece is within tolerance of its chord
+void Curve::subdivide(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, int depth, vector<glm::vec3>& out) const
+{
+	if (depth >= MAX_SUBDIVISIONS || getFlatness(p0, p1, p2, p3) <= tolerance) {
+		out.push_back(p3);
+		return;
+	}
+
+	glm::vec3 p01 = (p0 + p1) * 0.5f, p12 = (p1 + p2) * 0.5f, p23 = (p2 + p3) * 0.5f;
+	glm::vec3 p012 = (p01 + p12) * 0.5f, p123 = (p12 + p23) * 0.5f;
+	glm::vec3 middle = (p012 + p123) * 0.5f;
+
+	subdivide(p0, p01, p012, middle, depth + 1, out);
+	subdivide(middle, p123, p23, p3, depth + 1, out);
+}
+
+// arcLengths[i] is the distance from the first point of the slot, and the length of the segment
+// goes into the Fenwick tree, whose prefix sums give where each segment starts on the curve
+float Curve::updateArcLengths(int k)
+{
+	int first = k * slotSize;
+	int count = segmentCounts[k];
+
+	arcLengths[first] = 0.0f;
+	for (int i = first + 1; i < first + count; i++) {
+		arcLengths[i] = arcLengths[i - 1] + glm::distance(curvePoints[i - 1], curvePoints[i]);
+	}
+	return arcLengths[first + count - 1];
+}
+
+// Search of the segment in the Fenwick tree, then binary search for the sample pair around the
+// distance inside it, then linear interpolation between them. Distances outside [0, getLength()]
+// are clamped to the ends.
+glm::vec3 Curve::pointAtDistance(float distance) const
+{
+	int nSegments = segmentCounts.size();
+	if (nSegments == 0) {
+		return glm::vec3(0.0f);
+	}
+	if (distance <= 0.0f) {
+		return curvePoints.front();
+	}
+	if (distance >= getLength()) {
+		return curvePoints[(nSegments - 1) * slotSize + segmentCounts[nSegments - 1] - 1];
+	}
+
+	float local;
+	int k = segmentLengths.find(distance, local);
+
+	vector<float>::const_iterator begin = arcLengths.begin() + k * slotSize;
+	vector<float>::const_iterator end = begin + segmentCounts[k];
+	vector<float>::const_iterator next = upper_bound(begin, end, local);
+	if (next == end) {
+		return curvePoints[k * slotSize + segmentCounts[k] - 1];
+	}
+	if (next == begin) {
+		return curvePoints[k * slotSize];
+	}
+
+	size_t i = next - arcLengths.begin();
+	float span = arcLengths[i] - arcLengths[i - 1];
+	float a = span > 0.0f ? (local - arcLengths[i - 1]) / span : 0.0f;
+	return glm::mix(curvePoints[i - 1], curvePoints[i], a);
+}
+
+CurveHit Curve::closestPoint(const glm::vec3& p) const
+{
+	CurveHit hit = { 0.0f, glm::vec3(0.0f), -1.0f };
+	bvh.closestPoint(p, hit);
+	return hit;
+}
+
+// Position after moving for time seconds at speed units per second, starting over at the end of the curve
+glm::vec3 Curve::pointAtTime(float time, float speed) const
+{
+	float length = getLength();
+	if (length <= 0.0f) {
+		return pointAtDistance(0.0f);
+	}
+
+	float distance = fmod(time * speed, length);
+	return pointAtDistance(distance < 0.0f ? distance + length : distance);
+}
+
+// The buffer is created once and grows geometrically, so regenerating or editing the curve only
+// sends the points in [first, first + count) when they fit
+void Curve::uploadPoints(int first, int count)
+{
+	if (VAO == 0) {
+		createBuffers();
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+	int nPoints = curvePoints.size();
+	if (nPoints > capacity) {
+		capacity = max(nPoints, capacity * 2);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GLfloat) * 3, NULL, GL_DYNAMIC_DRAW);
+		first = 0;
+		count = nPoints;
+	}
+
+	// The slots that hold data, not the capacity: the slack past them is uninitialised
+	DrawValidator::track(VAO, name, nPoints, 0, GL_NONE, 0);
+
+	if (count > 0) {
+		glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(GLfloat) * 3, count * sizeof(GLfloat) * 3, &curvePoints[first]);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Curve::createBuffers()
+{
+	//Gerao do identificador do VBO
+	glGenBuffers(1, &VBO);
+
+	//Faz a conexo (vincula) do buffer como um buffer de array
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+	//Gerao do identificador do VAO (Vertex Array Object)
+	glGenVertexArrays(1, &VAO);
+
+	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vrtices
+	// e os ponteiros para os atributos 
+	glBindVertexArray(VAO);
+
+	//Atributo posio (x, y, z)
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+
+	// Observe que isso  permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vrtice 
+	// atualmente vinculado - para que depois possamos desvincular com segurana
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// Desvincula o VAO ( uma boa prtica desvincular qualquer buffer ou array para evitar bugs medonhos)
+	glBindVertexArray(0);
+}
+
+void Curve::destroy()
+{
+	if (VAO != 0) {
+		DrawValidator::untrack(VAO);
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+	}
+
+	VAO = VBO = 0;
+	capacity = 0;
+}
+
 void Curve::drawCurve(glm::vec4 color)
 {
 	shader->setVec4("finalColor", color.r, color.g, color.b, color.a);
 
+	for (size_t k = 0; k < segmentCounts.size(); k++) {
+		if (!DrawValidator::checkArrays(VAO, slotFirsts[k], segmentCounts[k])) {
+			return;
+		}
+	}
+
 	glBindVertexArray(VAO);
 	// Chamada de desenho - drawcall
 	// CONTORNO e PONTOS - GL_LINE_LOOP e GL_POINTS
-	glDrawArrays(GL_LINE_STRIP, 0, curvePoints.size());
-	//glDrawArrays(GL_POINTS, 0, curvePoints.size());
+	// Uma line strip por segmento, cada um no seu slot do buffer
+	glMultiDrawArrays(GL_LINE_STRIP, slotFirsts.data(), segmentCounts.data(), segmentCounts.size());
+	//glMultiDrawArrays(GL_POINTS, slotFirsts.data(), segmentCounts.data(), segmentCounts.size());
 	glBindVertexArray(0);
 
 }
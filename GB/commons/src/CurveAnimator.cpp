@@ -0,0 +1,43 @@
+#include "CurveAnimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+void CurveAnimator::setDuration(float seconds)
+{
+	if (seconds > 0.0f) {
+		speed = curve->getLength() / seconds;
+	}
+}
+
+void CurveAnimator::update(float deltaTime)
+{
+	float length = curve->getLength();
+	if (length <= 0.0f) {
+		travelled = 0.0f;
+		return;
+	}
+
+	travelled += speed * deltaTime;
+
+	// One period is a trip to the end (and back, for ping-pong)
+	if (mode == CLAMP) {
+		travelled = min(max(travelled, 0.0f), length);
+	}
+	else {
+		float period = mode == PING_PONG ? 2.0f * length : length;
+		travelled = fmod(travelled, period);
+		if (travelled < 0.0f) {
+			travelled += period;
+		}
+	}
+}
+
+float CurveAnimator::getDistance() const
+{
+	float length = curve->getLength();
+	if (mode == PING_PONG && travelled > length) {
+		return 2.0f * length - travelled;
+	}
+	return min(travelled, length);
+}
@@ -0,0 +1,111 @@
+#include "CurveBenchmark.h"
+#include "CurveEvaluator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+static const glm::mat4 BEZIER(-1, 3, -3, 1,
+	3, -6, 3, 0,
+	-3, 3, 0, 0,
+	1, 0, 0, 0
+);
+
+// Bezier::generateCurve as it was before the CurveEvaluator, minus the GL upload. The float t
+// accumulation is replaced by t = j * step so that both sides sample the same parameters.
+static void legacyGenerate(const vector<glm::vec3>& controlPoints, int pointsPerSegment, vector<glm::vec3>& curvePoints)
+{
+	float step = 1.0 / (float)pointsPerSegment;
+
+	int nControlPoints = controlPoints.size();
+
+	for (int i = 0; i < nControlPoints - 3; i += 3)
+	{
+		for (int j = 0; j <= pointsPerSegment; j++)
+		{
+			float t = (float)j * step;
+
+			glm::vec4 T(t * t * t, t * t, t, 1);
+
+			glm::mat4x3 G(controlPoints[i], controlPoints[i + 1], controlPoints[i + 2], controlPoints[i + 3]);
+
+			curvePoints.push_back(G * BEZIER * T);
+		}
+	}
+}
+
+static void batchGenerate(const vector<glm::vec3>& controlPoints, int pointsPerSegment, vector<glm::vec3>& curvePoints)
+{
+	float step = 1.0 / (float)pointsPerSegment;
+
+	int nControlPoints = controlPoints.size();
+	int nSegments = nControlPoints > 3 ? (nControlPoints - 1) / 3 : 0;
+
+	curvePoints.resize(nSegments * (pointsPerSegment + 1));
+
+	for (int i = 0; i < nControlPoints - 3; i += 3)
+	{
+		glm::mat4x3 G(controlPoints[i], controlPoints[i + 1], controlPoints[i + 2], controlPoints[i + 3]);
+		CubicSegment segment = CurveEvaluator::makeSegment(G, BEZIER);
+		CurveEvaluator::evaluate(segment, pointsPerSegment + 1, step, &curvePoints[i / 3 * (pointsPerSegment + 1)]);
+	}
+}
+
+static void report(const string& name, double seconds, int points)
+{
+	cout << name << ": " << seconds * 1000.0 << " ms, "
+		<< points / seconds << " points/s" << endl;
+}
+
+void CurveBenchmark::run(const vector<glm::vec3>& controlPoints)
+{
+	if (controlPoints.size() < 4) {
+		cout << "ERROR::CURVE_BENCHMARK::NOT_ENOUGH_CONTROL_POINTS" << endl;
+		return;
+	}
+
+	typedef chrono::high_resolution_clock Clock;
+
+	// A fresh vector each time, as generateCurve had for a new curve
+	vector<glm::vec3> legacyPoints;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		legacyPoints.clear();
+		legacyPoints.shrink_to_fit();
+		legacyGenerate(controlPoints, pointsPerSegment, legacyPoints);
+	}
+	double legacySeconds = chrono::duration<double>(Clock::now() - start).count() / iterations;
+
+	vector<glm::vec3> batchPoints;
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		batchPoints.clear();
+		batchPoints.shrink_to_fit();
+		batchGenerate(controlPoints, pointsPerSegment, batchPoints);
+	}
+	double batchSeconds = chrono::duration<double>(Clock::now() - start).count() / iterations;
+
+	int points = batchPoints.size();
+
+	// Picked at run time, from what this CPU supports
+	string lanes = string(CurveEvaluator::getInstructionSet()) + ", " + to_string(CurveEvaluator::getNbLanes()) + " lanes";
+
+	cout << controlPoints.size() << " control points, " << points << " curve points, " << iterations << " iterations" << endl;
+	report("G * M * T per point", legacySeconds, points);
+	report("CurveEvaluator (" + lanes + ")", batchSeconds, points);
+	cout << "Speedup: " << legacySeconds / batchSeconds << "x" << endl;
+
+	// Horner rounds differently from the matrix product, so only a tolerance relative to the size of the curve holds
+	float maxError = 0.0f;
+	float extent = 1.0f;
+	for (size_t i = 0; i < legacyPoints.size() && i < batchPoints.size(); i++) {
+		maxError = max(maxError, glm::length(legacyPoints[i] - batchPoints[i]));
+		extent = max(extent, glm::length(legacyPoints[i]));
+	}
+
+	cout << "Max difference: " << maxError << endl;
+	if (legacyPoints.size() != batchPoints.size() || maxError > 1e-5f * extent) {
+		cout << "WARNING: CurveEvaluator output differs from the G * M * T loop (max error " << maxError << ")" << endl;
+	}
+}
@@ -0,0 +1,224 @@
+#include "CurveBvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static glm::vec3 evaluate(const glm::mat4x3& C, float t)
+{
+	return ((C[0] * t + C[1]) * t + C[2]) * t + C[3];
+}
+
+void CurveBvh::build(const vector<glm::mat4x3>& segments)
+{
+	this->segments = segments;
+	nodes.clear();
+	leaves.assign(segments.size(), -1);
+
+	if (segments.empty()) {
+		return;
+	}
+
+	vector<int> order(segments.size());
+	vector<glm::vec3> centers(segments.size());
+	for (size_t k = 0; k < segments.size(); k++) {
+		glm::vec3 min, max;
+		getBounds(k, min, max);
+		order[k] = k;
+		centers[k] = (min + max) * 0.5f;
+	}
+
+	nodes.reserve(2 * segments.size() - 1);
+	buildNode(order, centers, 0, segments.size(), -1);
+}
+
+// Splits at the median of the box centers along their widest axis, so the tree stays balanced
+int CurveBvh::buildNode(vector<int>& order, const vector<glm::vec3>& centers, int first, int last, int parent)
+{
+	int index = nodes.size();
+	nodes.push_back(Node());
+
+	if (last - first == 1) {
+		Node& leaf = nodes[index];
+		leaf.left = leaf.right = -1;
+		leaf.parent = parent;
+		leaf.segment = order[first];
+		getBounds(leaf.segment, leaf.min, leaf.max);
+		leaves[leaf.segment] = index;
+		return index;
+	}
+
+	glm::vec3 min = centers[order[first]], max = min;
+	for (int i = first + 1; i < last; i++) {
+		min = glm::min(min, centers[order[i]]);
+		max = glm::max(max, centers[order[i]]);
+	}
+
+	glm::vec3 extent = max - min;
+	int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+
+	int middle = (first + last) / 2;
+	nth_element(order.begin() + first, order.begin() + middle, order.begin() + last,
+		[&centers, axis](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+	int left = buildNode(order, centers, first, middle, index);
+	int right = buildNode(order, centers, middle, last, index);
+
+	Node& node = nodes[index];
+	node.min = glm::min(nodes[left].min, nodes[right].min);
+	node.max = glm::max(nodes[left].max, nodes[right].max);
+	node.left = left;
+	node.right = right;
+	node.parent = parent;
+	node.segment = -1;
+	return index;
+}
+
+void CurveBvh::update(int k, const glm::mat4x3& segment)
+{
+	if (k < 0 || k >= (int)segments.size()) {
+		return;
+	}
+
+	segments[k] = segment;
+
+	int index = leaves[k];
+	getBounds(k, nodes[index].min, nodes[index].max);
+
+	for (index = nodes[index].parent; index >= 0; index = nodes[index].parent) {
+		Node& node = nodes[index];
+		node.min = glm::min(nodes[node.left].min, nodes[node.right].min);
+		node.max = glm::max(nodes[node.left].max, nodes[node.right].max);
+	}
+}
+
+// Box of the Bezier control points d, d + c / 3, d + (2c + b) / 3 and a + b + c + d
+void CurveBvh::getBounds(int k, glm::vec3& min, glm::vec3& max) const
+{
+	const glm::mat4x3& C = segments[k];
+	glm::vec3 p0 = C[3];
+	glm::vec3 p1 = C[3] + C[2] / 3.0f;
+	glm::vec3 p2 = C[3] + (2.0f * C[2] + C[1]) / 3.0f;
+	glm::vec3 p3 = C[0] + C[1] + C[2] + C[3];
+
+	min = glm::min(glm::min(p0, p1), glm::min(p2, p3));
+	max = glm::max(glm::max(p0, p1), glm::max(p2, p3));
+}
+
+// Newton's method on (q(t) - p) . q'(t) = 0 from t, halving the step when it overshoots, and
+// keeping a step only if it gets closer
+static void refine(const glm::mat4x3& C, const glm::vec3& p, int nbIterations, int nbHalvings, float& t, float& best)
+{
+	for (int i = 0; i < nbIterations; i++) {
+		glm::vec3 offset = evaluate(C, t) - p;
+		glm::vec3 tangent = (3.0f * C[0] * t + 2.0f * C[1]) * t + C[2];
+		glm::vec3 curvature = 6.0f * C[0] * t + 2.0f * C[1];
+
+		float slope = glm::dot(tangent, tangent) + glm::dot(offset, curvature);
+		if (slope <= 0.0f) {
+			return;
+		}
+
+		float step = glm::dot(offset, tangent) / slope;
+		bool closer = false;
+		for (int j = 0; j < nbHalvings && !closer; j++, step *= 0.5f) {
+			float u = glm::clamp(t - step, 0.0f, 1.0f);
+			glm::vec3 next = evaluate(C, u) - p;
+			float distance2 = glm::dot(next, next);
+			if (distance2 < best) {
+				best = distance2;
+				t = u;
+				closer = true;
+			}
+		}
+		if (!closer) {
+			return;
+		}
+	}
+}
+
+// Squared distance. Evenly spaced samples (the ends included) find the basins of the distance,
+// and each local minimum among them seeds the refinement, so a segment that bends back towards
+// p does not trap the search in the wrong one.
+float CurveBvh::closestOnSegment(int k, const glm::vec3& p, float& t) const
+{
+	const glm::mat4x3& C = segments[k];
+
+	float samples[NB_SEEDS];
+	for (int i = 0; i < NB_SEEDS; i++) {
+		glm::vec3 offset = evaluate(C, (float)i / (NB_SEEDS - 1)) - p;
+		samples[i] = glm::dot(offset, offset);
+	}
+
+	float best = FLT_MAX;
+	for (int i = 0; i < NB_SEEDS; i++) {
+		if ((i > 0 && samples[i - 1] < samples[i]) || (i + 1 < NB_SEEDS && samples[i + 1] < samples[i])) {
+			continue;
+		}
+
+		float u = (float)i / (NB_SEEDS - 1);
+		float distance2 = samples[i];
+		refine(C, p, NB_ITERATIONS, NB_HALVINGS, u, distance2);
+		if (distance2 < best) {
+			best = distance2;
+			t = u;
+		}
+	}
+
+	return best;
+}
+
+float CurveBvh::getDistance2(const Node& node, const glm::vec3& p)
+{
+	glm::vec3 outside = glm::max(glm::max(node.min - p, p - node.max), glm::vec3(0.0f));
+	return glm::dot(outside, outside);
+}
+
+bool CurveBvh::closestPoint(const glm::vec3& p, CurveHit& hit) const
+{
+	if (nodes.empty()) {
+		return false;
+	}
+
+	float best = FLT_MAX;
+	int bestSegment = 0;
+	float bestT = 0.0f;
+
+	// Balanced tree: the stack never holds more than its depth plus one
+	int stack[MAX_DEPTH];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0) {
+		const Node& node = nodes[stack[--top]];
+		if (getDistance2(node, p) >= best) {
+			continue;
+		}
+
+		if (node.segment >= 0) {
+			float t;
+			float distance2 = closestOnSegment(node.segment, p, t);
+			if (distance2 < best) {
+				best = distance2;
+				bestSegment = node.segment;
+				bestT = t;
+			}
+			continue;
+		}
+
+		// Nearest child on top, so that it is searched first and tightens best for the other one
+		if (getDistance2(nodes[node.left], p) < getDistance2(nodes[node.right], p)) {
+			stack[top++] = node.right;
+			stack[top++] = node.left;
+		}
+		else {
+			stack[top++] = node.left;
+			stack[top++] = node.right;
+		}
+	}
+
+	hit.t = bestSegment + bestT;
+	hit.point = evaluate(segments[bestSegment], bestT);
+	hit.distance = sqrt(best);
+	return true;
+}
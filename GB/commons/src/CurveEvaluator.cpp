@@ -0,0 +1,108 @@
+#include "CurveEvaluator.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CURVE_SSE2
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+// p = G * M * T with T = (t^3, t^2, t, 1), so the columns of G * M are the coefficients
+CubicSegment CurveEvaluator::makeSegment(const glm::mat4x3& G, const glm::mat4& M)
+{
+	glm::mat4x3 C = G * M;
+
+	CubicSegment segment;
+	for (int axis = 0; axis < 3; axis++) {
+		segment.a[axis] = C[0][axis];
+		segment.b[axis] = C[1][axis];
+		segment.c[axis] = C[2][axis];
+		segment.d[axis] = C[3][axis];
+	}
+	return segment;
+}
+
+void CurveEvaluator::evaluate(const CubicSegment& segment, int nbSamples, float step, glm::vec3* out)
+{
+	int i = 0;
+
+	if (hasAvx()) {
+		i = evaluateAvx(segment, nbSamples, step, out);
+	}
+
+#if defined(CURVE_SSE2)
+	// Everything without AVX, or what the 8-wide loop left over
+	const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	const __m128 steps = _mm_set1_ps(step);
+	alignas(16) float result[3][4];
+
+	for (; i + 4 <= nbSamples; i += 4) {
+		__m128 t = _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)i), lanes), steps);
+		for (int axis = 0; axis < 3; axis++) {
+			__m128 p = _mm_set1_ps(segment.a[axis]);
+			p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(segment.b[axis]));
+			p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(segment.c[axis]));
+			p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(segment.d[axis]));
+			_mm_store_ps(result[axis], p);
+		}
+		for (int lane = 0; lane < 4; lane++) {
+			out[i + lane] = glm::vec3(result[0][lane], result[1][lane], result[2][lane]);
+		}
+	}
+#endif
+
+	// Remaining samples, with the same t and the same operations as the vector lanes
+	for (; i < nbSamples; i++) {
+		float t = (float)i * step;
+		for (int axis = 0; axis < 3; axis++) {
+			out[i][axis] = ((segment.a[axis] * t + segment.b[axis]) * t + segment.c[axis]) * t + segment.d[axis];
+		}
+	}
+}
+
+// AVX instructions and the OS saving the YMM registers on a context switch
+bool CurveEvaluator::hasAvx()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	static const bool avx = [] {
+		int info[4];
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avxBit = (info[2] & (1 << 28)) != 0;
+		return osxsave && avxBit && (_xgetbv(0) & 6) == 6;
+	}();
+	return avx;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	static const bool avx = __builtin_cpu_supports("avx");
+	return avx;
+#else
+	return false;
+#endif
+}
+
+const char* CurveEvaluator::getInstructionSet()
+{
+	if (hasAvx()) {
+		return "AVX";
+	}
+#if defined(CURVE_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+int CurveEvaluator::getNbLanes()
+{
+	if (hasAvx()) {
+		return 8;
+	}
+#if defined(CURVE_SSE2)
+	return 4;
+#else
+	return 1;
+#endif
+}
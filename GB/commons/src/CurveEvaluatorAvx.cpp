@@ -0,0 +1,47 @@
+#include "CurveEvaluator.h"
+
+// Built with /arch:AVX (see the project) or the avx target attribute, unlike the rest of the
+// program; CurveEvaluator::evaluate() only comes here after checking the CPU
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#include <immintrin.h>
+
+#if defined(__GNUC__)
+#define CURVE_AVX_TARGET __attribute__((target("avx")))
+#else
+#define CURVE_AVX_TARGET
+#endif
+
+CURVE_AVX_TARGET int CurveEvaluator::evaluateAvx(const CubicSegment& segment, int nbSamples, float step, glm::vec3* out)
+{
+	const __m256 lanes = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+	const __m256 steps = _mm256_set1_ps(step);
+	alignas(32) float result[3][8];
+
+	int i = 0;
+	for (; i + 8 <= nbSamples; i += 8) {
+		__m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps((float)i), lanes), steps);
+		for (int axis = 0; axis < 3; axis++) {
+			__m256 p = _mm256_set1_ps(segment.a[axis]);
+			p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(segment.b[axis]));
+			p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(segment.c[axis]));
+			p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(segment.d[axis]));
+			_mm256_store_ps(result[axis], p);
+		}
+		// Member by member: a glm function built here would be AVX code the linker may pick for everyone
+		for (int lane = 0; lane < 8; lane++) {
+			out[i + lane].x = result[0][lane];
+			out[i + lane].y = result[1][lane];
+			out[i + lane].z = result[2][lane];
+		}
+	}
+
+	// Leaving 256-bit code: avoids the AVX to SSE transition penalty in the caller
+	_mm256_zeroupper();
+	return i;
+}
+#else
+int CurveEvaluator::evaluateAvx(const CubicSegment& segment, int nbSamples, float step, glm::vec3* out)
+{
+	return 0;
+}
+#endif
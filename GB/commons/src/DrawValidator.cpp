@@ -0,0 +1,83 @@
+#include "DrawValidator.h"
+
+#ifdef _DEBUG
+
+#include <cstddef>
+#include <iostream>
+#include <map>
+
+struct TrackedBuffers {
+	string name;
+	int nbVertices;
+	int nbIndices;
+	GLenum indexType;
+	unsigned int maxIndex;
+	bool reported;
+};
+
+static map<GLuint, TrackedBuffers> trackedVAOs;
+
+static bool report(TrackedBuffers& buffers, const string& message)
+{
+	if (!buffers.reported) {
+		cout << "ERROR::DRAW::" << message << " (mesh: " << buffers.name << ")" << endl;
+		buffers.reported = true;
+	}
+	return false;
+}
+
+void DrawValidator::track(GLuint VAO, const string& name, int nbVertices, int nbIndices, GLenum indexType, unsigned int maxIndex)
+{
+	TrackedBuffers buffers = { name, nbVertices, nbIndices, indexType, maxIndex, false };
+	trackedVAOs[VAO] = buffers;
+}
+
+void DrawValidator::untrack(GLuint VAO)
+{
+	trackedVAOs.erase(VAO);
+}
+
+bool DrawValidator::checkArrays(GLuint VAO, GLint first, GLsizei count)
+{
+	map<GLuint, TrackedBuffers>::iterator found = trackedVAOs.find(VAO);
+	if (found == trackedVAOs.end()) {
+		return true;
+	}
+
+	TrackedBuffers& buffers = found->second;
+	if (first < 0 || count < 0 || (long long)first + count > buffers.nbVertices) {
+		return report(buffers, "VERTEX_RANGE_OVERRUN: requested [" + to_string(first) + ", " + to_string((long long)first + count)
+			+ ") of " + to_string(buffers.nbVertices) + " vertices");
+	}
+
+	return true;
+}
+
+bool DrawValidator::checkElements(GLuint VAO, GLsizei count, GLenum indexType, const void* offset)
+{
+	map<GLuint, TrackedBuffers>::iterator found = trackedVAOs.find(VAO);
+	if (found == trackedVAOs.end()) {
+		return true;
+	}
+
+	TrackedBuffers& buffers = found->second;
+	if (indexType != buffers.indexType) {
+		return report(buffers, "INDEX_TYPE_MISMATCH");
+	}
+
+	size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : indexType == GL_UNSIGNED_BYTE ? sizeof(GLubyte) : sizeof(GLuint);
+	size_t first = (size_t)offset / indexSize;
+	if (count < 0 || first + count > (size_t)buffers.nbIndices) {
+		return report(buffers, "INDEX_RANGE_OVERRUN: requested [" + to_string(first) + ", " + to_string(first + count)
+			+ ") of " + to_string(buffers.nbIndices) + " indices");
+	}
+
+	if (buffers.nbIndices > 0 && buffers.maxIndex >= (unsigned int)buffers.nbVertices) {
+		return report(buffers, "INDEX_OUT_OF_BOUNDS: index " + to_string(buffers.maxIndex) + " with "
+			+ to_string(buffers.nbVertices) + " vertices");
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// How long the files must stay untouched before a change is handed out
+static const chrono::milliseconds SETTLE_TIME(50);
+static const int WAIT_MS = 250;
+
+static string getDirectory(const string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == string::npos ? "." : path.substr(0, slash + 1);
+}
+
+FileWatcher::~FileWatcher()
+{
+	stop();
+}
+
+size_t FileWatcher::hashFile(const string& path)
+{
+	ifstream file(path, ios::binary);
+	string contents((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	return hash<string>()(contents);
+}
+
+void FileWatcher::watch(const string& path)
+{
+	unique_lock<mutex> guard(lock);
+	if (fileHashes.find(path) != fileHashes.end()) {
+		return;
+	}
+	fileHashes[path] = hashFile(path);
+	if (directories.insert(getDirectory(path)).second) {
+		newDirectories.push_back(getDirectory(path));
+	}
+}
+
+vector<string> FileWatcher::takeNewDirectories()
+{
+	unique_lock<mutex> guard(lock);
+	vector<string> taken;
+	taken.swap(newDirectories);
+	return taken;
+}
+
+void FileWatcher::start()
+{
+	if (!watcher.joinable()) {
+		{
+			unique_lock<mutex> guard(lock);
+			stopping = false;
+			// A new thread sets up its notifications from scratch
+			newDirectories.assign(directories.begin(), directories.end());
+		}
+		watcher = thread(&FileWatcher::run, this);
+	}
+}
+
+void FileWatcher::stop()
+{
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+	if (watcher.joinable()) {
+		watcher.join();
+	}
+}
+
+bool FileWatcher::takeChanges(vector<string>& changed, chrono::steady_clock::time_point& firstChange)
+{
+	unique_lock<mutex> guard(lock);
+	if (changedFiles.empty() || chrono::steady_clock::now() - lastChange < SETTLE_TIME) {
+		return false;
+	}
+
+	changed.swap(changedFiles);
+	changedFiles.clear();
+	firstChange = this->firstChange;
+	return true;
+}
+
+void FileWatcher::checkFiles()
+{
+	unique_lock<mutex> guard(lock);
+	for (unordered_map<string, size_t>::iterator it = fileHashes.begin(); it != fileHashes.end(); ++it) {
+		size_t fileHash = hashFile(it->first);
+		if (fileHash == it->second) {
+			continue;
+		}
+
+		it->second = fileHash;
+		lastChange = chrono::steady_clock::now();
+		if (changedFiles.empty()) {
+			firstChange = lastChange;
+		}
+		if (find(changedFiles.begin(), changedFiles.end(), it->first) == changedFiles.end()) {
+			changedFiles.push_back(it->first);
+		}
+	}
+}
+
+void FileWatcher::run()
+{
+#if defined(_WIN32)
+	vector<HANDLE> handles;
+#elif defined(__linux__)
+	int notifier = inotify_init1(IN_NONBLOCK);
+#endif
+
+	while (true) {
+		{
+			unique_lock<mutex> guard(lock);
+			if (stopping) {
+				break;
+			}
+		}
+
+		// Directories of the files added since the last turn (all of them on the first one)
+		vector<string> added = takeNewDirectories();
+		for (size_t i = 0; i < added.size(); i++) {
+#if defined(_WIN32)
+			if (handles.size() < MAXIMUM_WAIT_OBJECTS) {
+				HANDLE handle = FindFirstChangeNotificationA(added[i].c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+				if (handle != INVALID_HANDLE_VALUE) {
+					handles.push_back(handle);
+				}
+			}
+#elif defined(__linux__)
+			// Directories rather than files: editors that save through a rename would drop a file watch
+			if (notifier >= 0) {
+				inotify_add_watch(notifier, added[i].c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY);
+			}
+#endif
+		}
+		// Catches what was saved between watch() and the notifications being set up
+		if (!added.empty()) {
+			checkFiles();
+		}
+
+		// Wakes up at least every WAIT_MS to notice stop()
+		bool notified = false;
+#if defined(_WIN32)
+		if (handles.empty()) {
+			Sleep(WAIT_MS);
+			notified = true;
+		}
+		else {
+			DWORD signaled = WaitForMultipleObjects(handles.size(), handles.data(), FALSE, WAIT_MS);
+			if (signaled >= WAIT_OBJECT_0 && signaled < WAIT_OBJECT_0 + handles.size()) {
+				FindNextChangeNotification(handles[signaled - WAIT_OBJECT_0]);
+				notified = true;
+			}
+		}
+#elif defined(__linux__)
+		if (notifier < 0) {
+			this_thread::sleep_for(chrono::milliseconds(WAIT_MS));
+			notified = true;
+		}
+		else {
+			pollfd request = { notifier, POLLIN, 0 };
+			if (poll(&request, 1, WAIT_MS) > 0) {
+				char events[4096];
+				while (read(notifier, events, sizeof(events)) > 0) {
+				}
+				notified = true;
+			}
+		}
+#else
+		this_thread::sleep_for(chrono::milliseconds(WAIT_MS));
+		notified = true;
+#endif
+
+		if (notified) {
+			checkFiles();
+		}
+	}
+
+#if defined(_WIN32)
+	for (size_t i = 0; i < handles.size(); i++) {
+		FindCloseChangeNotification(handles[i]);
+	}
+#elif defined(__linux__)
+	if (notifier >= 0) {
+		close(notifier);
+	}
+#endif
+}
@@ -0,0 +1,185 @@
+#include "Mesh.h"
+#include "DrawValidator.h"
+#include "ObjReader.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+//GLM
+#include <glm/gtc/packing.hpp>
+
+// Octahedral normal encoding: the unit sphere is projected on the octahedron |x| + |y| + |z| = 1 and
+// the lower half is folded over the upper one, so two components are enough. Decoded in shaders.vs.
+static void encodeNormal(float x, float y, float z, GLshort* out)
+{
+	float length = fabs(x) + fabs(y) + fabs(z);
+	float u = 0.0f, v = 0.0f;
+
+	if (length > 0.0f) {
+		u = x / length;
+		v = y / length;
+		if (z < 0.0f) {
+			float foldedU = (1.0f - fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+			float foldedV = (1.0f - fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+			u = foldedU;
+			v = foldedV;
+		}
+	}
+
+	out[0] = (GLshort)glm::packSnorm1x16(u);
+	out[1] = (GLshort)glm::packSnorm1x16(v);
+}
+
+// Input in the ObjReader layout: position, texcoord and normal, with no vertex color
+MeshData Mesh::pack(const vector<float>& vertices, const vector<unsigned int>& indices)
+{
+	const int IN = ObjReader::FLOATS_PER_VERTEX;
+
+	MeshData data;
+	data.nbVertices = vertices.size() / IN;
+	data.nbIndices = indices.size();
+	data.format.flags = 0;
+
+	for (size_t i = 3; i + 1 < vertices.size(); i += IN) {
+		if (vertices[i] < 0.0f || vertices[i] > 1.0f || vertices[i + 1] < 0.0f || vertices[i + 1] > 1.0f) {
+			data.format.flags |= VertexFormat::HALF_UV;
+			break;
+		}
+	}
+
+	for (int axis = 0; axis < 3; axis++) {
+		data.boundsMin[axis] = data.nbVertices > 0 ? FLT_MAX : 0.0f;
+		data.boundsMax[axis] = data.nbVertices > 0 ? -FLT_MAX : 0.0f;
+	}
+
+	int stride = data.format.getStride();
+	data.vertexData.resize((size_t)data.nbVertices * stride);
+
+	for (int i = 0; i < data.nbVertices; i++) {
+		const float* in = vertices.data() + (size_t)i * IN;
+		unsigned char* out = data.vertexData.data() + (size_t)i * stride;
+
+		memcpy(out, in, 3 * sizeof(GLfloat));
+		for (int axis = 0; axis < 3; axis++) {
+			data.boundsMin[axis] = min(data.boundsMin[axis], in[axis]);
+			data.boundsMax[axis] = max(data.boundsMax[axis], in[axis]);
+		}
+
+		GLshort normal[2];
+		encodeNormal(in[5], in[6], in[7], normal);
+		memcpy(out + 12, normal, sizeof(normal));
+
+		GLushort uv[2];
+		if (data.format.flags & VertexFormat::HALF_UV) {
+			uv[0] = glm::packHalf1x16(in[3]);
+			uv[1] = glm::packHalf1x16(in[4]);
+		}
+		else {
+			uv[0] = glm::packUnorm1x16(in[3]);
+			uv[1] = glm::packUnorm1x16(in[4]);
+		}
+		memcpy(out + 16, uv, sizeof(uv));
+	}
+
+	data.indexType = chooseIndexType(data.nbVertices);
+	if (data.indexType == GL_UNSIGNED_SHORT) {
+		vector<GLushort> shortIndices(indices.begin(), indices.end());
+		data.indexData.resize(shortIndices.size() * sizeof(GLushort));
+		memcpy(data.indexData.data(), shortIndices.data(), data.indexData.size());
+	}
+	else {
+		data.indexData.resize(indices.size() * sizeof(GLuint));
+		memcpy(data.indexData.data(), indices.data(), data.indexData.size());
+	}
+
+	return data;
+}
+
+unsigned int Mesh::getMaxIndex(const void* indexData, int nbIndices, GLenum indexType)
+{
+	unsigned int maxIndex = 0;
+	for (int i = 0; i < nbIndices; i++) {
+		unsigned int index = indexType == GL_UNSIGNED_SHORT ? ((const GLushort*)indexData)[i] : ((const GLuint*)indexData)[i];
+		maxIndex = index > maxIndex ? index : maxIndex;
+	}
+	return maxIndex;
+}
+
+void Mesh::upload(const MeshData& data)
+{
+	upload(data.format, data.vertexData.data(), data.nbVertices, data.indexData.data(), data.nbIndices, data.indexType);
+}
+
+void Mesh::upload(const VertexFormat& format, const void* vertexData, int nbVertices, const void* indexData, int nbIndices, GLenum indexType)
+{
+	destroy();
+
+	this->nbVertices = nbVertices;
+	this->nbIndices = nbIndices;
+	this->indexType = indexType;
+
+	int stride = format.getStride();
+
+	glGenVertexArrays(1, &VAO);
+	glBindVertexArray(VAO);
+
+	glGenBuffers(1, &VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)nbVertices * stride, vertexData, GL_STATIC_DRAW);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+	if (format.flags & VertexFormat::COLOR) {
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (GLvoid*)20);
+		glEnableVertexAttribArray(1);
+	}
+	if (format.flags & VertexFormat::HALF_UV) {
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (GLvoid*)16);
+	}
+	else {
+		glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (GLvoid*)16);
+	}
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (GLvoid*)12);
+	glEnableVertexAttribArray(3);
+
+	// The element buffer binding is part of the VAO state, so it stays bound until the VAO is unbound
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	GLsizeiptr indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, nbIndices * indexSize, indexData, GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+#ifdef _DEBUG
+	DrawValidator::track(VAO, name, nbVertices, nbIndices, indexType, getMaxIndex(indexData, nbIndices, indexType));
+#endif
+}
+
+void Mesh::draw()
+{
+	if (!DrawValidator::checkElements(VAO, nbIndices, indexType, 0)) {
+		return;
+	}
+
+	glBindVertexArray(VAO);
+	glDrawElements(GL_TRIANGLES, nbIndices, indexType, 0);
+	glBindVertexArray(0);
+}
+
+void Mesh::destroy()
+{
+	if (VAO != 0) {
+		DrawValidator::untrack(VAO);
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+	}
+
+	VAO = VBO = EBO = 0;
+	nbVertices = nbIndices = 0;
+}
@@ -0,0 +1,168 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "HashUtils.h"
+
+#include <climits>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+static const char MAGIC[4] = { 'G', 'B', 'M', 'C' };
+
+// Size and last write time (100 ns units on Windows, ns elsewhere) without opening the file
+static bool getFileStamp(const string& filename, unsigned long long& size, unsigned long long& time)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &info)) {
+		return false;
+	}
+	size = ((unsigned long long)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+	time = ((unsigned long long)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat info;
+	if (stat(filename.c_str(), &info) != 0) {
+		return false;
+	}
+	size = info.st_size;
+	time = (unsigned long long)info.st_mtim.tv_sec * 1000000000ull + info.st_mtim.tv_nsec;
+#endif
+	return true;
+}
+
+bool MeshCache::hashSource()
+{
+	MappedFile source;
+	if (!source.open(sourceFilename)) {
+		return false;
+	}
+
+	sourceHash = hashBytes(source.getData(), source.getSize());
+	sourceSize = source.getSize();
+	hashed = true;
+	return true;
+}
+
+// The OBJ was found unchanged under a new time: storing it saves the hash on the next launch
+void MeshCache::refreshTime(MeshCacheHeader header) const
+{
+	header.sourceTime = sourceTime;
+
+	fstream file(getCachePath(sourceFilename), ios::in | ios::out | ios::binary);
+	if (file.is_open()) {
+		file.write((const char*)&header, sizeof(header));
+	}
+}
+
+bool MeshCache::load(const string& sourceFilename, Mesh& mesh)
+{
+	this->sourceFilename = sourceFilename;
+	hashed = false;
+	hasSource = getFileStamp(sourceFilename, sourceSize, sourceTime);
+	if (!hasSource) {
+		return false;
+	}
+
+	MappedFile cache;
+	if (!cache.open(getCachePath(sourceFilename)) || cache.getSize() < sizeof(MeshCacheHeader)) {
+		return false;
+	}
+
+	MeshCacheHeader header;
+	memcpy(&header, cache.getData(), sizeof(header));
+
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+		|| header.sourceSize != sourceSize || header.vertexLayout != Mesh::VERTEX_LAYOUT) {
+		return false;
+	}
+
+	bool touched = header.sourceTime != sourceTime;
+	if (touched && (!hashSource() || header.sourceHash != sourceHash || header.sourceSize != sourceSize)) {
+		return false;
+	}
+
+	VertexFormat format;
+	format.flags = header.vertexFlags;
+	if ((header.vertexFlags & ~(VertexFormat::COLOR | VertexFormat::HALF_UV)) != 0
+		|| header.vertexStride != (unsigned int)format.getStride()) {
+		return false;
+	}
+
+	GLenum indexType = Mesh::chooseIndexType(header.nbVertices);
+	unsigned int indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	unsigned long long fileSize = cache.getSize();
+	unsigned long long vertexBytes = (unsigned long long)header.nbVertices * header.vertexStride;
+	unsigned long long indexBytes = (unsigned long long)header.nbIndices * indexSize;
+
+	// A truncated or inconsistent file is treated like a stale one. Each blob must lie past the
+	// header and inside the file; sizes are compared with what is left after the offset, so no
+	// sum can wrap around.
+	if (header.indexSize != indexSize
+		|| header.nbVertices == 0 || header.nbVertices > INT_MAX || header.nbIndices > INT_MAX || header.nbIndices % 3 != 0
+		|| header.vertexOffset < sizeof(header) || header.vertexOffset > fileSize || vertexBytes > fileSize - header.vertexOffset
+		|| header.indexOffset < sizeof(header) || header.indexOffset % indexSize != 0 || header.indexOffset > fileSize || indexBytes > fileSize - header.indexOffset) {
+		return false;
+	}
+
+	// The stamp check trusts the blobs without hashing them, and release builds have no DrawValidator:
+	// an index past the vertices would make the GPU read out of bounds. One pass over the mapped
+	// indices is small next to the upload.
+	const char* indexData = cache.getData() + header.indexOffset;
+	if (header.nbIndices > 0 && Mesh::getMaxIndex(indexData, header.nbIndices, indexType) >= header.nbVertices) {
+		return false;
+	}
+
+	mesh.upload(format, cache.getData() + header.vertexOffset, header.nbVertices, indexData, header.nbIndices, indexType);
+
+	// Written only once the mapping is gone, which Windows requires
+	cache.close();
+	if (touched) {
+		refreshTime(header);
+	}
+
+	return true;
+}
+
+bool MeshCache::store(const MeshData& data)
+{
+	// Only a fresh or touched OBJ was hashed by load()
+	if (!hasSource || (!hashed && !hashSource())) {
+		return false;
+	}
+
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	header.vertexLayout = Mesh::VERTEX_LAYOUT;
+	header.vertexFlags = data.format.flags;
+	header.vertexStride = data.format.getStride();
+	header.nbVertices = data.nbVertices;
+	header.nbIndices = data.nbIndices;
+	header.indexSize = data.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	memcpy(header.boundsMin, data.boundsMin, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, data.boundsMax, sizeof(header.boundsMax));
+	header.vertexOffset = sizeof(header);
+	header.indexOffset = header.vertexOffset + data.vertexData.size();
+
+	ofstream file(getCachePath(sourceFilename), ios::binary | ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)data.vertexData.data(), data.vertexData.size());
+	file.write((const char*)data.indexData.data(), data.indexData.size());
+
+	return file.good();
+}
@@ -0,0 +1,433 @@
+#include "MipChain.h"
+#include "BlockCompressor.h"
+#include "MappedFile.h"
+#include "HashUtils.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+// SSE2 only, the baseline of every x64 build. Unlike CurveEvaluator there is no AVX path picked at
+// run time: chains are built on the decode threads and baked to disk, so only the first load of an
+// image pays for them.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIPCHAIN_SSE2
+#endif
+
+static const char MAGIC[4] = { 'G', 'B', 'M', 'P' };
+
+// 8-bit value to linear [0, 1], and linear back to 8 bits through a finer table
+struct ColorTables {
+	float toLinear[2][256];
+	unsigned char fromLinear[2][4096];
+
+	ColorTables()
+	{
+		for (int i = 0; i < 256; i++) {
+			float c = i / 255.0f;
+			toLinear[0][i] = c;
+			toLinear[1][i] = c <= 0.04045f ? c / 12.92f : pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (int i = 0; i < 4096; i++) {
+			float c = i / 4095.0f;
+			float s = c <= 0.0031308f ? c * 12.92f : 1.055f * pow(c, 1.0f / 2.4f) - 0.055f;
+			fromLinear[0][i] = (unsigned char)(c * 255.0f + 0.5f);
+			fromLinear[1][i] = (unsigned char)(min(max(s, 0.0f), 1.0f) * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const ColorTables& getColorTables()
+{
+	static ColorTables tables;
+	return tables;
+}
+
+// Weights of a 2:1 reduction along one axis: output i reads the source at 2i, 2i + 1 and, for an
+// odd source size, 2i + 2. Odd sizes use the 3-tap polyphase box (weights (m - i) / n, m / n and
+// (i + 1) / n for n = 2m + 1), so the last row or column is not dropped and every source texel
+// weighs the same in total.
+struct Reduction {
+	int nbTaps;
+	vector<float> weights[3];
+};
+
+static void getReduction(int sourceSize, int targetSize, Reduction& reduction)
+{
+	reduction.nbTaps = sourceSize == 1 ? 1 : (sourceSize % 2 == 0 ? 2 : 3);
+	for (int k = 0; k < 3; k++) {
+		reduction.weights[k].resize(targetSize);
+	}
+
+	for (int i = 0; i < targetSize; i++) {
+		if (reduction.nbTaps == 1) {
+			reduction.weights[0][i] = 1.0f;
+		}
+		else if (reduction.nbTaps == 2) {
+			reduction.weights[0][i] = reduction.weights[1][i] = 0.5f;
+		}
+		else {
+			reduction.weights[0][i] = (float)(targetSize - i) / sourceSize;
+			reduction.weights[1][i] = (float)targetSize / sourceSize;
+			reduction.weights[2][i] = (float)(i + 1) / sourceSize;
+		}
+	}
+}
+
+// Rows are kept as four planes (all the reds, then greens, blues and alphas), so each SSE2
+// instruction works on four texels of one channel
+
+static void decodeRow(const unsigned char* pixels, int width, const float* toLinear, float* out)
+{
+	for (int x = 0; x < width; x++) {
+		const unsigned char* texel = pixels + (size_t)x * 4;
+		out[x] = toLinear[texel[0]];
+		out[width + x] = toLinear[texel[1]];
+		out[2 * width + x] = toLinear[texel[2]];
+		out[3 * width + x] = texel[3] / 255.0f;
+	}
+}
+
+// out = the sum of rows[k] * weights[k]
+static void blendRows(const float* const* rows, const float* weights, int nbRows, int size, float* out)
+{
+	int i = 0;
+#ifdef MIPCHAIN_SSE2
+	for (; i + 4 <= size; i += 4) {
+		__m128 sum = _mm_mul_ps(_mm_loadu_ps(rows[0] + i), _mm_set1_ps(weights[0]));
+		for (int k = 1; k < nbRows; k++) {
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), _mm_set1_ps(weights[k])));
+		}
+		_mm_storeu_ps(out + i, sum);
+	}
+#endif
+	for (; i < size; i++) {
+		float sum = rows[0][i] * weights[0];
+		for (int k = 1; k < nbRows; k++) {
+			sum += rows[k][i] * weights[k];
+		}
+		out[i] = sum;
+	}
+}
+
+// One plane of a row, reduced along x
+static void reduceRow(const float* row, int sourceWidth, int targetWidth, const Reduction& reduction, float* out)
+{
+	const float* w0 = reduction.weights[0].data();
+	const float* w1 = reduction.weights[1].data();
+	const float* w2 = reduction.weights[2].data();
+	int x = 0;
+
+#ifdef MIPCHAIN_SSE2
+	// Four outputs from eight consecutive inputs: the even ones and the odd ones
+	if (reduction.nbTaps == 2) {
+		for (; 2 * x + 8 <= sourceWidth; x += 4) {
+			__m128 a = _mm_loadu_ps(row + 2 * x), b = _mm_loadu_ps(row + 2 * x + 4);
+			__m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+			_mm_storeu_ps(out + x, _mm_mul_ps(_mm_add_ps(even, odd), _mm_set1_ps(0.5f)));
+		}
+	}
+	else if (reduction.nbTaps == 3) {
+		for (; 2 * x + 10 <= sourceWidth; x += 4) {
+			__m128 a = _mm_loadu_ps(row + 2 * x), b = _mm_loadu_ps(row + 2 * x + 4);
+			__m128 c = _mm_loadu_ps(row + 2 * x + 2), d = _mm_loadu_ps(row + 2 * x + 6);
+			__m128 first = _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), _mm_loadu_ps(w0 + x));
+			__m128 middle = _mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), _mm_loadu_ps(w1 + x));
+			__m128 last = _mm_mul_ps(_mm_shuffle_ps(c, d, _MM_SHUFFLE(2, 0, 2, 0)), _mm_loadu_ps(w2 + x));
+			_mm_storeu_ps(out + x, _mm_add_ps(_mm_add_ps(first, middle), last));
+		}
+	}
+#endif
+
+	for (; x < targetWidth; x++) {
+		if (reduction.nbTaps == 1) {
+			out[x] = row[2 * x];
+		}
+		else if (reduction.nbTaps == 2) {
+			out[x] = (row[2 * x] + row[2 * x + 1]) * 0.5f;
+		}
+		else {
+			out[x] = row[2 * x] * w0[x] + row[2 * x + 1] * w1[x] + row[2 * x + 2] * w2[x];
+		}
+	}
+}
+
+// Back to 8-bit RGBA; the table index (or alpha) is computed four texels at a time
+static void encodeRow(const float* row, int width, const unsigned char* fromLinear, unsigned char* out)
+{
+	int x = 0;
+
+#ifdef MIPCHAIN_SSE2
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f);
+	const __m128 scales[4] = { _mm_set1_ps(4095.0f), _mm_set1_ps(4095.0f), _mm_set1_ps(4095.0f), _mm_set1_ps(255.0f) };
+	alignas(16) int values[4][4];
+
+	for (; x + 4 <= width; x += 4) {
+		for (int c = 0; c < 4; c++) {
+			__m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(row + c * width + x), zero), one);
+			_mm_store_si128((__m128i*)values[c], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scales[c]), half)));
+		}
+		for (int i = 0; i < 4; i++) {
+			unsigned char* texel = out + (size_t)(x + i) * 4;
+			texel[0] = fromLinear[values[0][i]];
+			texel[1] = fromLinear[values[1][i]];
+			texel[2] = fromLinear[values[2][i]];
+			texel[3] = (unsigned char)values[3][i];
+		}
+	}
+#endif
+
+	for (; x < width; x++) {
+		unsigned char* texel = out + (size_t)x * 4;
+		for (int c = 0; c < 3; c++) {
+			texel[c] = fromLinear[(int)(min(max(row[c * width + x], 0.0f), 1.0f) * 4095.0f + 0.5f)];
+		}
+		texel[3] = (unsigned char)(min(max(row[3 * width + x], 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+}
+
+void MipChain::build(const unsigned char* pixels, int width, int height, bool srgb)
+{
+	const ColorTables& tables = getColorTables();
+	const float* toLinear = tables.toLinear[srgb ? 1 : 0];
+	const unsigned char* fromLinear = tables.fromLinear[srgb ? 1 : 0];
+
+	this->srgb = srgb;
+	format = RGBA8;
+	levels.clear();
+
+	MipLevel base;
+	base.width = width;
+	base.height = height;
+	base.data.assign(pixels, pixels + (size_t)width * height * 4);
+	levels.push_back(base);
+
+	// Level 0 is never expanded to floats as a whole: its rows go through the table as they are
+	// needed, which keeps the float buffer at a quarter of the image
+	vector<float> source, target, filtered;
+	vector<float> decoded[3];
+	Reduction columns, rows;
+	int sourceWidth = width, sourceHeight = height;
+
+	while (sourceWidth > 1 || sourceHeight > 1) {
+		int targetWidth = max(sourceWidth / 2, 1);
+		int targetHeight = max(sourceHeight / 2, 1);
+		getReduction(sourceWidth, targetWidth, columns);
+		getReduction(sourceHeight, targetHeight, rows);
+		target.resize((size_t)targetWidth * targetHeight * 4);
+		filtered.resize((size_t)sourceWidth * 4);
+		bool fromBase = levels.size() == 1;
+
+		MipLevel level;
+		level.width = targetWidth;
+		level.height = targetHeight;
+		level.data.resize(target.size());
+
+		// Separable: the source rows are blended first, then the result is reduced along x
+		for (int y = 0; y < targetHeight; y++) {
+			const float* sourceRows[3];
+			float weights[3];
+			for (int k = 0; k < rows.nbTaps; k++) {
+				int sourceY = 2 * y + k;
+				if (fromBase) {
+					decoded[k].resize((size_t)sourceWidth * 4);
+					decodeRow(pixels + (size_t)sourceY * sourceWidth * 4, sourceWidth, toLinear, decoded[k].data());
+					sourceRows[k] = decoded[k].data();
+				}
+				else {
+					sourceRows[k] = &source[(size_t)sourceY * sourceWidth * 4];
+				}
+				weights[k] = rows.weights[k][y];
+			}
+			blendRows(sourceRows, weights, rows.nbTaps, sourceWidth * 4, filtered.data());
+
+			float* targetRow = &target[(size_t)y * targetWidth * 4];
+			for (int c = 0; c < 4; c++) {
+				reduceRow(&filtered[(size_t)c * sourceWidth], sourceWidth, targetWidth, columns, targetRow + c * targetWidth);
+			}
+			encodeRow(targetRow, targetWidth, fromLinear, &level.data[(size_t)y * targetWidth * 4]);
+		}
+
+		levels.push_back(level);
+
+		source.swap(target);
+		sourceWidth = targetWidth;
+		sourceHeight = targetHeight;
+	}
+}
+
+void MipChain::compress()
+{
+	if (format != RGBA8 || levels.empty()) {
+		return;
+	}
+
+	// BC1 has no useful alpha, so it is only picked when the base level is fully opaque
+	const vector<unsigned char>& base = levels[0].data;
+	bool opaque = true;
+	for (size_t i = 3; i < base.size() && opaque; i += 4) {
+		opaque = base[i] == 255;
+	}
+	format = opaque ? BC1 : BC3;
+
+	for (MipLevel& level : levels) {
+		vector<unsigned char> blocks;
+		if (format == BC1) {
+			BlockCompressor::compressBC1(level.data.data(), level.width, level.height, blocks);
+		}
+		else {
+			BlockCompressor::compressBC3(level.data.data(), level.width, level.height, blocks);
+		}
+		level.data.swap(blocks);
+	}
+}
+
+size_t MipChain::getSize() const
+{
+	size_t size = 0;
+	for (const MipLevel& level : levels) {
+		size += level.data.size();
+	}
+	return size;
+}
+
+bool MipChain::load(const string& filename, unsigned long long sourceHash, unsigned long long sourceSize, bool srgb, bool compressed)
+{
+	levels.clear();
+
+	MappedFile file;
+	if (!file.open(filename) || file.getSize() < sizeof(MipCacheHeader)) {
+		return false;
+	}
+
+	MipCacheHeader header;
+	memcpy(&header, file.getData(), sizeof(header));
+
+	if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+		|| header.sourceHash != sourceHash || header.sourceSize != sourceSize || header.srgb != (srgb ? 1u : 0u)
+		|| (header.format != RGBA8) != compressed || header.format > BC3
+		|| header.width == 0 || header.height == 0 || header.width > INT_MAX || header.height > INT_MAX
+		|| header.nbLevels == 0 || header.nbLevels > 32
+		|| sizeof(header) + (unsigned long long)header.nbLevels * sizeof(MipLevelIndex) > file.getSize()) {
+		return false;
+	}
+
+	const MipLevelIndex* index = (const MipLevelIndex*)(file.getData() + sizeof(header));
+	int width = header.width, height = header.height;
+
+	for (unsigned int i = 0; i < header.nbLevels; i++) {
+		size_t expectedSize = header.format == RGBA8 ? (size_t)width * height * 4
+			: BlockCompressor::getCompressedSize(width, height, header.format == BC1 ? 8 : 16);
+
+		// A truncated or inconsistent file is treated like a stale one. The size is compared with what
+		// is left after the offset, so a huge offset cannot wrap the sum around.
+		if (index[i].size != expectedSize || index[i].offset < sizeof(header) || index[i].offset > file.getSize()
+			|| index[i].size > file.getSize() - index[i].offset) {
+			levels.clear();
+			return false;
+		}
+
+		MipLevel level;
+		level.width = width;
+		level.height = height;
+		level.data.assign(file.getData() + index[i].offset, file.getData() + index[i].offset + index[i].size);
+		levels.push_back(level);
+
+		width = max(width / 2, 1);
+		height = max(height / 2, 1);
+	}
+
+	this->srgb = srgb;
+	format = header.format;
+	return !levels.empty();
+}
+
+bool MipChain::store(const string& filename, unsigned long long sourceHash, unsigned long long sourceSize) const
+{
+	if (levels.empty()) {
+		return false;
+	}
+
+	MipCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.width = levels[0].width;
+	header.height = levels[0].height;
+	header.nbLevels = levels.size();
+	header.srgb = srgb ? 1 : 0;
+	header.format = format;
+
+	vector<MipLevelIndex> index(levels.size());
+	unsigned long long offset = sizeof(header) + index.size() * sizeof(MipLevelIndex);
+	for (size_t i = 0; i < levels.size(); i++) {
+		index[i].offset = offset;
+		index[i].size = levels[i].data.size();
+		offset += index[i].size;
+	}
+
+	ofstream file(filename, ios::binary | ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)index.data(), index.size() * sizeof(MipLevelIndex));
+	for (const MipLevel& level : levels) {
+		file.write((const char*)level.data.data(), level.data.size());
+	}
+
+	return file.good();
+}
+
+bool MipChain::loadImage(const string& imageFilename, unsigned long long sourceHash, unsigned long long sourceSize, bool srgb, bool compressed)
+{
+	string cachePath = getCachePath(imageFilename);
+	if (sourceSize > 0 && load(cachePath, sourceHash, sourceSize, srgb, compressed)) {
+		return true;
+	}
+
+	int width, height;
+	unsigned char* pixels = stbi_load(imageFilename.c_str(), &width, &height, NULL, 4);
+	if (pixels == nullptr) {
+		levels.clear();
+		return false;
+	}
+
+	build(pixels, width, height, srgb);
+	stbi_image_free(pixels);
+
+	if (compressed) {
+		compress();
+	}
+
+	// Without a hash there is nothing to key the baked chain on
+	if (sourceSize > 0) {
+		store(cachePath, sourceHash, sourceSize);
+	}
+
+	return true;
+}
+
+bool MipChain::bake(const string& imageFilename, bool srgb, bool compressed)
+{
+	MappedFile source;
+	if (!source.open(imageFilename)) {
+		return false;
+	}
+
+	unsigned long long sourceHash = hashBytes(source.getData(), source.getSize());
+	unsigned long long sourceSize = source.getSize();
+	source.close();
+
+	// loadImage() writes the chain when no valid one is found
+	MipChain chain;
+	return chain.loadImage(imageFilename, sourceHash, sourceSize, srgb, compressed);
+}
@@ -0,0 +1,210 @@
+#include "ObjBenchmark.h"
+#include "ObjReader.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+struct LegacyVertex {
+	float x, y, z, r = 0.1f, g = 0.1f, b = 0.1f;
+};
+
+struct LegacyTexture {
+	float s, t;
+};
+
+struct LegacyNormal {
+	float x, y, z;
+};
+
+struct LegacyFace {
+	LegacyVertex vertices[3];
+	LegacyTexture textures[3];
+	LegacyNormal normals[3];
+};
+
+static vector<string> legacySplit(const string& input, char delimiter)
+{
+	vector<string> tokens;
+	istringstream iss(input);
+	string token;
+
+	while (getline(iss, token, delimiter)) {
+		tokens.push_back(token);
+	}
+
+	return tokens;
+}
+
+// The loader as it was before ObjReader, minus the GL upload
+static vector<float> legacyLoad(const string& filename)
+{
+	ifstream file(filename);
+
+	vector<LegacyVertex> uniqueVertices;
+	vector<LegacyTexture> uniqueTextures;
+	vector<LegacyNormal> uniqueNormals;
+	vector<LegacyFace> faces;
+
+	vector<float> buffer;
+
+	string line;
+
+	while (getline(file, line)) {
+		vector<string> row = legacySplit(line, ' ');
+
+		if (row.empty()) {
+			continue;
+		}
+
+		if (row[0] == "v") {
+			LegacyVertex vertex;
+			vertex.x = stof(row[1]);
+			vertex.y = stof(row[2]);
+			vertex.z = stof(row[3]);
+			uniqueVertices.push_back(vertex);
+		}
+
+		if (row[0] == "vt") {
+			LegacyTexture texture;
+			texture.s = stof(row[1]);
+			texture.t = stof(row[2]);
+			uniqueTextures.push_back(texture);
+		}
+
+		if (row[0] == "vn") {
+			LegacyNormal normal;
+			normal.x = stof(row[1]);
+			normal.y = stof(row[2]);
+			normal.z = stof(row[3]);
+			uniqueNormals.push_back(normal);
+		}
+
+		if (row[0] == "f") {
+			LegacyFace face;
+
+			for (int i = 0; i < 3; i++) {
+				vector<string> corner = legacySplit(row[i + 1], '/');
+				face.vertices[i] = uniqueVertices[stoi(corner[0]) - 1];
+				face.textures[i] = uniqueTextures[stoi(corner[1]) - 1];
+				face.normals[i] = uniqueNormals[stoi(corner[2]) - 1];
+			}
+
+			faces.push_back(face);
+		}
+	}
+
+	for (LegacyFace face : faces)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			buffer.push_back(face.vertices[i].x);
+			buffer.push_back(face.vertices[i].y);
+			buffer.push_back(face.vertices[i].z);
+
+			buffer.push_back(face.vertices[i].r);
+			buffer.push_back(face.vertices[i].g);
+			buffer.push_back(face.vertices[i].b);
+
+			buffer.push_back(face.textures[i].s);
+			buffer.push_back(face.textures[i].t);
+
+			buffer.push_back(face.normals[i].x);
+			buffer.push_back(face.normals[i].y);
+			buffer.push_back(face.normals[i].z);
+		}
+	}
+
+	return buffer;
+}
+
+// Back to one vertex per triangle corner, to compare with the legacy output
+static vector<float> expand(const ObjReader& reader)
+{
+	const vector<float>& vertices = reader.getVertices();
+	vector<float> buffer;
+
+	for (unsigned int index : reader.getIndices()) {
+		buffer.insert(buffer.end(), vertices.begin() + index * ObjReader::FLOATS_PER_VERTEX, vertices.begin() + (index + 1) * ObjReader::FLOATS_PER_VERTEX);
+	}
+
+	return buffer;
+}
+
+// The legacy loader also wrote a constant color after each position, which ObjReader leaves out
+static vector<float> dropColors(const vector<float>& legacyVertices)
+{
+	const int LEGACY_FLOATS_PER_VERTEX = 11;
+	vector<float> buffer;
+
+	for (size_t i = 0; i + LEGACY_FLOATS_PER_VERTEX <= legacyVertices.size(); i += LEGACY_FLOATS_PER_VERTEX) {
+		buffer.insert(buffer.end(), legacyVertices.begin() + i, legacyVertices.begin() + i + 3);
+		buffer.insert(buffer.end(), legacyVertices.begin() + i + 6, legacyVertices.begin() + i + LEGACY_FLOATS_PER_VERTEX);
+	}
+
+	return buffer;
+}
+
+static void report(const string& name, double seconds, double megabytes, int triangles)
+{
+	cout << name << ": " << seconds * 1000.0 << " ms, "
+		<< megabytes / seconds << " MB/s, "
+		<< triangles / seconds << " triangles/s" << endl;
+}
+
+void ObjBenchmark::run(const string& filename)
+{
+	ifstream file(filename, ios::binary | ios::ate);
+
+	if (!file.is_open()) {
+		cout << "Unable to open the file: " << filename << endl;
+		return;
+	}
+
+	double megabytes = file.tellg() / (1024.0 * 1024.0);
+	file.close();
+
+	typedef chrono::high_resolution_clock Clock;
+
+	vector<float> legacyVertices;
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		legacyVertices = legacyLoad(filename);
+	}
+	double legacySeconds = chrono::duration<double>(Clock::now() - start).count() / iterations;
+
+	ObjReader reader;
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		reader.read(filename);
+	}
+	double readerSeconds = chrono::duration<double>(Clock::now() - start).count() / iterations;
+
+	ThreadPool pool;
+	ObjReader parallelReader;
+	parallelReader.setThreadPool(&pool);
+	start = Clock::now();
+	for (int i = 0; i < iterations; i++) {
+		parallelReader.read(filename);
+	}
+	double parallelSeconds = chrono::duration<double>(Clock::now() - start).count() / iterations;
+
+	int triangles = reader.getNbTriangles();
+
+	cout << filename << ": " << megabytes << " MB, " << triangles << " triangles, " << iterations << " iterations" << endl;
+	report("getline/split", legacySeconds, megabytes, triangles);
+	report("ObjReader", readerSeconds, megabytes, triangles);
+	report("ObjReader, " + to_string(pool.getNbThreads()) + " threads", parallelSeconds, megabytes, triangles);
+	cout << "Indexed: " << reader.getNbVertices() << " unique vertices, reuse factor " << (double)reader.getIndices().size() / reader.getNbVertices() << endl;
+	cout << "Speedup: " << legacySeconds / readerSeconds << "x serial, " << legacySeconds / parallelSeconds << "x parallel" << endl;
+
+	if (dropColors(legacyVertices) != expand(reader)) {
+		cout << "WARNING: ObjReader output differs from the getline/split loader" << endl;
+	}
+
+	if (parallelReader.getVertices() != reader.getVertices() || parallelReader.getIndices() != reader.getIndices()) {
+		cout << "WARNING: parallel ObjReader output differs from the serial one" << endl;
+	}
+}
@@ -0,0 +1,303 @@
+#include "ObjReader.h"
+#include "MappedFile.h"
+#include "ParseUtils.h"
+
+#include <algorithm>
+
+// Below this size a chunk is not worth a task of its own
+static const size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+// Face corner with 0-based indices. Negative OBJ indices count back from the end of the list read so far,
+// which inside a chunk is only known relative to the chunk start: those are flagged and rebased on merge.
+struct Corner {
+	int v, t, n;
+	unsigned char relative;
+};
+
+static const unsigned char RELATIVE_V = 1, RELATIVE_T = 2, RELATIVE_N = 4;
+
+// Resolved 0-based attribute indices of a face corner, -1 when missing
+struct VertexKey {
+	int v, t, n;
+	bool operator==(const VertexKey& other) const { return v == other.v && t == other.t && n == other.n; }
+};
+
+struct ObjChunk {
+	const char* begin;
+	const char* end;
+	vector<float> positions;
+	vector<float> texCoords;
+	vector<float> normals;
+	vector<Corner> corners;
+	size_t firstPosition = 0, firstTexCoord = 0, firstNormal = 0, firstCorner = 0;
+};
+
+static int toChunkIndex(int index, int localCount, unsigned char flag, unsigned char& relative)
+{
+	if (index < 0) {
+		relative |= flag;
+		return localCount + index;
+	}
+	// 0 means the attribute is missing and maps to -1, which is rejected on merge
+	return index - 1;
+}
+
+static const char* parseCorner(const char* p, const char* end, const ObjChunk& chunk, Corner& corner)
+{
+	int v = 0, t = 0, n = 0;
+
+	const char* next = parseInt(p, end, v);
+	if (next == p) {
+		return p;
+	}
+	p = next;
+
+	if (p < end && *p == '/') {
+		p = parseInt(p + 1, end, t);
+		if (p < end && *p == '/') {
+			p = parseInt(p + 1, end, n);
+		}
+	}
+
+	corner.relative = 0;
+	corner.v = toChunkIndex(v, chunk.positions.size() / 3, RELATIVE_V, corner.relative);
+	corner.t = toChunkIndex(t, chunk.texCoords.size() / 2, RELATIVE_T, corner.relative);
+	corner.n = toChunkIndex(n, chunk.normals.size() / 3, RELATIVE_N, corner.relative);
+
+	return p;
+}
+
+static void parseFace(const char* p, const char* end, ObjChunk& chunk)
+{
+	// Polygons are triangulated as a fan around the first corner
+	Corner first, previous, current;
+	int nbCorners = 0;
+
+	p = skipBlanks(p, end);
+
+	while (p < end) {
+		const char* next = parseCorner(p, end, chunk, current);
+		if (next == p) {
+			break;
+		}
+		p = skipBlanks(next, end);
+
+		if (nbCorners == 0) {
+			first = current;
+		}
+		else if (nbCorners >= 2) {
+			chunk.corners.push_back(first);
+			chunk.corners.push_back(previous);
+			chunk.corners.push_back(current);
+		}
+
+		previous = current;
+		nbCorners++;
+	}
+}
+
+static void parseChunk(ObjChunk& chunk)
+{
+	const char* p = chunk.begin;
+	const char* end = chunk.end;
+
+	while (p < end) {
+		p = skipBlanks(p, end);
+
+		const char* lineEnd = findLineEnd(p, end);
+
+		if (lineEnd - p >= 2 && p[0] == 'v' && isBlank(p[1])) {
+			float x = 0, y = 0, z = 0;
+			const char* q = skipBlanks(p + 2, lineEnd);
+			q = skipBlanks(parseFloat(q, lineEnd, x), lineEnd);
+			q = skipBlanks(parseFloat(q, lineEnd, y), lineEnd);
+			parseFloat(q, lineEnd, z);
+			chunk.positions.push_back(x);
+			chunk.positions.push_back(y);
+			chunk.positions.push_back(z);
+		}
+		else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isBlank(p[2])) {
+			float s = 0, t = 0;
+			const char* q = skipBlanks(p + 3, lineEnd);
+			q = skipBlanks(parseFloat(q, lineEnd, s), lineEnd);
+			parseFloat(q, lineEnd, t);
+			chunk.texCoords.push_back(s);
+			chunk.texCoords.push_back(t);
+		}
+		else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2])) {
+			float x = 0, y = 0, z = 0;
+			const char* q = skipBlanks(p + 3, lineEnd);
+			q = skipBlanks(parseFloat(q, lineEnd, x), lineEnd);
+			q = skipBlanks(parseFloat(q, lineEnd, y), lineEnd);
+			parseFloat(q, lineEnd, z);
+			chunk.normals.push_back(x);
+			chunk.normals.push_back(y);
+			chunk.normals.push_back(z);
+		}
+		else if (lineEnd - p >= 2 && p[0] == 'f' && isBlank(p[1])) {
+			parseFace(p + 2, lineEnd, chunk);
+		}
+
+		p = lineEnd < end ? lineEnd + 1 : end;
+	}
+}
+
+static int resolveIndex(int index, bool relative, size_t first, size_t count)
+{
+	long long resolved = relative ? (long long)first + index : index;
+	return resolved >= 0 && resolved < (long long)count ? (int)resolved : -1;
+}
+
+bool ObjReader::read(const string& filename)
+{
+	MappedFile file;
+
+	if (!file.open(filename)) {
+		return false;
+	}
+
+	parse(file.getData(), file.getEnd());
+
+	return true;
+}
+
+void ObjReader::parse(const char* begin, const char* end)
+{
+	// Split at line boundaries: every chunk but the first starts right after a '\n'
+	size_t size = end - begin;
+	int nbChunks = 1;
+	if (pool != nullptr) {
+		nbChunks = (int)max<size_t>(1, min<size_t>(pool->getNbThreads() * 4, size / MIN_CHUNK_SIZE));
+	}
+
+	vector<ObjChunk> chunks(nbChunks);
+	const char* chunkBegin = begin;
+	for (int i = 0; i < nbChunks; i++) {
+		const char* chunkEnd = i == nbChunks - 1 ? end : begin + size * (i + 1) / nbChunks;
+		chunkEnd = max(chunkEnd, chunkBegin);
+		chunkEnd = chunkEnd < end ? findLineEnd(chunkEnd, end) : end;
+		chunkEnd = chunkEnd < end ? chunkEnd + 1 : end;
+		chunks[i].begin = chunkBegin;
+		chunks[i].end = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
+
+	runTasks(nbChunks, [&chunks](int i) { parseChunk(chunks[i]); });
+
+	// Ordered merge: chunk i's attributes come after everything read by chunks 0..i-1
+	size_t nbPositions = 0, nbTexCoords = 0, nbNormals = 0, nbCorners = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.firstPosition = nbPositions;
+		chunk.firstTexCoord = nbTexCoords;
+		chunk.firstNormal = nbNormals;
+		chunk.firstCorner = nbCorners;
+		nbPositions += chunk.positions.size() / 3;
+		nbTexCoords += chunk.texCoords.size() / 2;
+		nbNormals += chunk.normals.size() / 3;
+		nbCorners += chunk.corners.size();
+	}
+
+	positions.resize(nbPositions * 3);
+	texCoords.resize(nbTexCoords * 2);
+	normals.resize(nbNormals * 3);
+	runTasks(nbChunks, [this, &chunks](int i) {
+		ObjChunk& chunk = chunks[i];
+		copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.firstPosition * 3);
+		copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.firstTexCoord * 2);
+		copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.firstNormal * 3);
+	});
+
+	vector<VertexKey> keys(nbCorners);
+	runTasks(nbChunks, [this, &chunks, &keys](int i) { resolveChunk(chunks[i], keys); });
+
+	buildVertices(keys);
+}
+
+void ObjReader::runTasks(int nbTasks, const function<void(int)>& task)
+{
+	if (pool != nullptr) {
+		pool->parallelFor(nbTasks, task);
+		return;
+	}
+
+	for (int i = 0; i < nbTasks; i++) {
+		task(i);
+	}
+}
+
+void ObjReader::resolveChunk(const ObjChunk& chunk, vector<VertexKey>& keys)
+{
+	size_t nbPositions = positions.size() / 3, nbTexCoords = texCoords.size() / 2, nbNormals = normals.size() / 3;
+	VertexKey* out = keys.data() + chunk.firstCorner;
+
+	for (const Corner& corner : chunk.corners) {
+		out->v = resolveIndex(corner.v, (corner.relative & RELATIVE_V) != 0, chunk.firstPosition, nbPositions);
+		out->t = resolveIndex(corner.t, (corner.relative & RELATIVE_T) != 0, chunk.firstTexCoord, nbTexCoords);
+		out->n = resolveIndex(corner.n, (corner.relative & RELATIVE_N) != 0, chunk.firstNormal, nbNormals);
+		out++;
+	}
+}
+
+static size_t hashKey(const VertexKey& key)
+{
+	unsigned long long h = (unsigned int)key.v;
+	h = h * 0x9E3779B97F4A7C15ULL + (unsigned int)key.t;
+	h = h * 0x9E3779B97F4A7C15ULL + (unsigned int)key.n;
+	return (size_t)(h ^ (h >> 29));
+}
+
+void ObjReader::buildVertices(const vector<VertexKey>& keys)
+{
+	static const unsigned int EMPTY = 0xFFFFFFFF;
+
+	// Open addressing table of unique vertex numbers; vertices are numbered in order of first use,
+	// so the result does not depend on how the file was chunked
+	size_t capacity = 16;
+	while (capacity < keys.size() * 2) {
+		capacity *= 2;
+	}
+
+	vector<unsigned int> table(capacity, EMPTY);
+	vector<VertexKey> uniqueKeys;
+	indices.resize(keys.size());
+
+	for (size_t i = 0; i < keys.size(); i++) {
+		const VertexKey& key = keys[i];
+		size_t slot = hashKey(key) & (capacity - 1);
+
+		while (table[slot] != EMPTY && !(uniqueKeys[table[slot]] == key)) {
+			slot = (slot + 1) & (capacity - 1);
+		}
+
+		if (table[slot] == EMPTY) {
+			table[slot] = uniqueKeys.size();
+			uniqueKeys.push_back(key);
+		}
+
+		indices[i] = table[slot];
+	}
+
+	vertices.resize(uniqueKeys.size() * FLOATS_PER_VERTEX);
+
+	int nbTasks = pool != nullptr ? pool->getNbThreads() : 1;
+	runTasks(nbTasks, [this, &uniqueKeys, nbTasks](int task) {
+		size_t first = uniqueKeys.size() * task / nbTasks, last = uniqueKeys.size() * (task + 1) / nbTasks;
+		float* out = vertices.data() + first * FLOATS_PER_VERTEX;
+
+		for (size_t i = first; i < last; i++) {
+			int v = uniqueKeys[i].v, t = uniqueKeys[i].t, n = uniqueKeys[i].n;
+
+			// Missing or invalid attributes are written as zeros
+			*out++ = v >= 0 ? positions[v * 3] : 0.0f;
+			*out++ = v >= 0 ? positions[v * 3 + 1] : 0.0f;
+			*out++ = v >= 0 ? positions[v * 3 + 2] : 0.0f;
+
+			*out++ = t >= 0 ? texCoords[t * 2] : 0.0f;
+			*out++ = t >= 0 ? texCoords[t * 2 + 1] : 0.0f;
+
+			*out++ = n >= 0 ? normals[n * 3] : 0.0f;
+			*out++ = n >= 0 ? normals[n * 3 + 1] : 0.0f;
+			*out++ = n >= 0 ? normals[n * 3 + 2] : 0.0f;
+		}
+	});
+}
@@ -0,0 +1,173 @@
+#include "Renderer.h"
+#include "DrawValidator.h"
+
+#include <algorithm>
+#include <cstring>
+
+//GLM
+#include <glm/gtc/type_ptr.hpp>
+
+void Renderer::init()
+{
+	glGenBuffers(1, &frameUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BINDING, frameUBO);
+
+	// Every material range must start at a multiple of the driver's offset alignment
+	GLint alignment = 1;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	alignment = max(alignment, 1);
+	materialStride = (sizeof(MaterialUniforms) + alignment - 1) / alignment * alignment;
+}
+
+void Renderer::destroy()
+{
+	glDeleteBuffers(1, &frameUBO);
+	glDeleteBuffers(1, &materialUBO);
+	frameUBO = materialUBO = 0;
+}
+
+int Renderer::addMaterial(const Material& material)
+{
+	MaterialUniforms uniforms;
+	uniforms.ka = glm::vec4(material.ka, 0.0f);
+	uniforms.kd = glm::vec4(material.kd, 0.0f);
+	uniforms.ks = glm::vec4(material.ks, 0.0f);
+	uniforms.q = material.ns;
+	uniforms.ni = material.ni;
+	uniforms.d = material.d;
+	uniforms.layer = material.layer;
+	uniforms.uvTransform = material.uvTransform;
+
+	materialData.push_back(uniforms);
+	materialTextures.push_back(material.texKd);
+	materialTargets.push_back(material.layer >= 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D);
+
+	return materialData.size() - 1;
+}
+
+void Renderer::uploadMaterials()
+{
+	vector<unsigned char> buffer(materialData.size() * materialStride);
+	for (size_t i = 0; i < materialData.size(); i++) {
+		memcpy(buffer.data() + i * materialStride, &materialData[i], sizeof(MaterialUniforms));
+	}
+
+	if (materialUBO == 0) {
+		glGenBuffers(1, &materialUBO);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, materialUBO);
+	glBufferData(GL_UNIFORM_BUFFER, buffer.size(), buffer.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void Renderer::beginFrame(const FrameUniforms& frame)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	draws.clear();
+}
+
+void Renderer::submit(Shader* shader, int material, const Mesh& mesh, const glm::mat4& model)
+{
+	map<Shader*, ModelUniform>::iterator found = modelUniforms.find(shader);
+	if (found == modelUniforms.end() || found->second.program != shader->ID) {
+		ModelUniform uniform = { shader->ID, shader->getUniform<Mat4Uniform>("model") };
+		modelUniforms[shader] = uniform;
+	}
+
+	DrawItem item;
+	item.shader = shader;
+	item.material = material;
+	item.texture = materialTextures[material];
+	item.target = materialTargets[material];
+	item.mesh = &mesh;
+	item.model = model;
+
+	// 16 bits per state, most expensive change first
+	item.key = ((unsigned long long)(shader->ID & 0xFFFF) << 48) | ((unsigned long long)(material & 0xFFFF) << 32)
+		| ((unsigned long long)(item.texture & 0xFFFF) << 16) | (mesh.getVAO() & 0xFFFF);
+
+	draws.push_back(item);
+}
+
+void Renderer::flush()
+{
+	stable_sort(draws.begin(), draws.end(), [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+
+	// Other code may have touched the GL state since the last flush, so nothing is assumed bound
+	GLuint boundProgram = 0, boundTexture = 0, boundArray = 0, boundVAO = 0;
+	int boundMaterial = -1;
+	nbDraws = 0;
+	nbSkippedBinds = 0;
+
+	glActiveTexture(GL_TEXTURE0);
+
+	for (size_t i = 0; i < draws.size(); i++) {
+		const DrawItem& item = draws[i];
+		const Mesh& mesh = *item.mesh;
+
+		if (!DrawValidator::checkElements(mesh.getVAO(), mesh.getNbIndices(), mesh.getIndexType(), 0)) {
+			continue;
+		}
+
+		if (item.shader->ID != boundProgram) {
+			glUseProgram(item.shader->ID);
+			boundProgram = item.shader->ID;
+		}
+		else {
+			nbSkippedBinds++;
+		}
+
+		if (item.material != boundMaterial) {
+			glBindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BINDING, materialUBO, item.material * materialStride, sizeof(MaterialUniforms));
+			boundMaterial = item.material;
+		}
+		else {
+			nbSkippedBinds++;
+		}
+
+		if (item.target == GL_TEXTURE_2D_ARRAY) {
+			if (item.texture != boundArray) {
+				glActiveTexture(GL_TEXTURE0 + ARRAY_TEXTURE_UNIT);
+				glBindTexture(GL_TEXTURE_2D_ARRAY, item.texture);
+				glActiveTexture(GL_TEXTURE0);
+				boundArray = item.texture;
+			}
+			else {
+				nbSkippedBinds++;
+			}
+		}
+		else if (item.texture != boundTexture) {
+			glBindTexture(GL_TEXTURE_2D, item.texture);
+			boundTexture = item.texture;
+		}
+		else {
+			nbSkippedBinds++;
+		}
+
+		if (mesh.getVAO() != boundVAO) {
+			glBindVertexArray(mesh.getVAO());
+			boundVAO = mesh.getVAO();
+		}
+		else {
+			nbSkippedBinds++;
+		}
+
+		item.shader->setMat4(modelUniforms[item.shader].handle, (float*)glm::value_ptr(item.model));
+		glDrawElements(GL_TRIANGLES, mesh.getNbIndices(), mesh.getIndexType(), 0);
+		nbDraws++;
+	}
+
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	if (boundArray != 0) {
+		glActiveTexture(GL_TEXTURE0 + ARRAY_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glActiveTexture(GL_TEXTURE0);
+	}
+}
@@ -0,0 +1,344 @@
+#include "ShaderLibrary.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+static string getDirectory(const string& filename)
+{
+	size_t slash = filename.find_last_of("/\\");
+	return slash == string::npos ? "" : filename.substr(0, slash + 1);
+}
+
+bool ShaderLibrary::appendFile(const string& filename, string& out, set<string>& included, bool topLevel, const string& defines)
+{
+	ifstream file(filename);
+	if (!file.is_open()) {
+		cout << "Unable to open the file: " << filename << endl;
+		return false;
+	}
+
+	bool valid = true;
+	string line;
+	int lineNumber = 0;
+
+	while (getline(file, line)) {
+		lineNumber++;
+
+		size_t first = line.find_first_not_of(" \t");
+		if (first != string::npos && line.compare(first, 8, "#include") == 0) {
+			size_t open = line.find('"', first + 8);
+			size_t close = open != string::npos ? line.find('"', open + 1) : string::npos;
+			if (close == string::npos) {
+				cout << "ERROR::SHADER::INVALID_INCLUDE: " << filename << ":" << lineNumber << endl;
+				valid = false;
+				continue;
+			}
+
+			// Pasted once, like #pragma once
+			string includedFile = getDirectory(filename) + line.substr(open + 1, close - open - 1);
+			if (included.insert(includedFile).second) {
+				out += "#line 1\n";
+				valid = appendFile(includedFile, out, included, false, defines) && valid;
+			}
+			// Compile errors keep pointing at the right line of this file
+			out += "#line " + to_string(lineNumber + 1) + "\n";
+			continue;
+		}
+
+		out += line + "\n";
+
+		// Defines must come after #version, which has to stay the first statement
+		if (topLevel && first != string::npos && line.compare(first, 8, "#version") == 0) {
+			out += defines;
+			out += "#line " + to_string(lineNumber + 1) + "\n";
+		}
+	}
+
+	return valid;
+}
+
+string ShaderLibrary::preprocess(const string& filename, const string& defines, set<string>* files)
+{
+	string out;
+	set<string> included;
+	included.insert(filename);
+	appendFile(filename, out, included, true, defines);
+	if (files != NULL) {
+		files->insert(included.begin(), included.end());
+	}
+	return out;
+}
+
+string ShaderLibrary::getDefines(unsigned int features) const
+{
+	string defines;
+	if (features & TEXTURED) {
+		defines += "#define TEXTURED\n";
+	}
+	if (features & VERTEX_COLOR) {
+		defines += "#define VERTEX_COLOR\n";
+	}
+	if (features & SPECULAR) {
+		defines += "#define SPECULAR\n";
+	}
+	defines += "#define NUM_LIGHTS " + to_string(nbLights) + "\n";
+	return defines;
+}
+
+void ShaderLibrary::build(const vector<unsigned int>& featureSets)
+{
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+	bool parallel = Shader::enableParallelCompile();
+
+	vector<Shader*> started;
+	for (size_t i = 0; i < featureSets.size(); i++) {
+		if (variants.find(featureSets[i]) != variants.end()) {
+			continue;
+		}
+
+		string defines = getDefines(featureSets[i]);
+		Shader* shader = new Shader();
+		shader->compile(preprocess(vertexPath, defines, &sourceFiles), preprocess(fragmentPath, defines, &sourceFiles));
+		variants[featureSets[i]].reset(shader);
+		started.push_back(shader);
+	}
+
+	// Only now is any status read, so the compiles above could overlap
+	for (size_t i = 0; i < started.size(); i++) {
+		started[i]->finish();
+	}
+
+	double elapsed = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+	cout << started.size() << " shader variants built in " << elapsed << " ms"
+		<< (parallel ? " (KHR_parallel_shader_compile)" : "") << endl;
+}
+
+// Variants missing from build() are compiled on the spot
+Shader* ShaderLibrary::get(unsigned int features)
+{
+	map<unsigned int, unique_ptr<Shader>>::iterator found = variants.find(features);
+	if (found != variants.end()) {
+		return found->second.get();
+	}
+
+	build(vector<unsigned int>(1, features));
+	return variants[features].get();
+}
+
+void ShaderLibrary::destroy()
+{
+	watcher.stop();
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_one();
+	if (compiler.joinable()) {
+		compiler.join();
+	}
+	if (compilerWindow != NULL) {
+		glfwDestroyWindow(compilerWindow);
+		compilerWindow = NULL;
+	}
+	if (reloadFence != 0) {
+		glDeleteSync(reloadFence);
+		reloadFence = 0;
+	}
+	for (map<unsigned int, unique_ptr<Shader>>::iterator it = variants.begin(); it != variants.end(); ++it) {
+		glDeleteProgram(it->second->ID);
+	}
+	for (map<unsigned int, unique_ptr<Shader>>::iterator it = reloading.begin(); it != reloading.end(); ++it) {
+		glDeleteProgram(it->second->ID);
+	}
+	variants.clear();
+	reloading.clear();
+}
+
+// Watches every file the built variants were made of, includes too
+void ShaderLibrary::enableHotReload(GLFWwindow* window)
+{
+	for (set<string>::iterator it = sourceFiles.begin(); it != sourceFiles.end(); ++it) {
+		watcher.watch(*it);
+	}
+	watcher.start();
+
+	// A context can only be made current with a window of its own; this one is never shown
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	compilerWindow = glfwCreateWindow(1, 1, "", NULL, window);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+	if (compilerWindow == NULL) {
+		cout << "ERROR::SHADER::NO_SHARED_CONTEXT: reloads are compiled on the render thread" << endl;
+		return;
+	}
+	compiler = thread(&ShaderLibrary::compileReloads, this);
+}
+
+// Runs on the reload thread, with the hidden context current
+void ShaderLibrary::compileReloads()
+{
+	glfwMakeContextCurrent(compilerWindow);
+
+	unique_lock<mutex> guard(lock);
+	while (true) {
+		wake.wait(guard, [this] { return stopping || compileRequested; });
+		if (stopping) {
+			break;
+		}
+		guard.unlock();
+
+		// Waiting here only holds up this thread, so each variant is finished right away
+		bool valid = true;
+		set<string> files;
+		for (map<unsigned int, unique_ptr<Shader>>::iterator it = reloading.begin(); it != reloading.end(); ++it) {
+			string defines = getDefines(it->first);
+			it->second->compile(preprocess(vertexPath, defines, &files), preprocess(fragmentPath, defines, &files));
+			valid = it->second->finish() && valid;
+		}
+
+		// Flushed, or the render context could wait on a fence that never reaches the driver
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+
+		guard.lock();
+		reloadFence = fence;
+		reloadValid = valid;
+		reloadFiles.swap(files);
+		compileRequested = false;
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
+
+// Whether the reload thread is done and its programs can be used here; never waits
+bool ShaderLibrary::takeReloads(bool& valid)
+{
+	unique_lock<mutex> guard(lock);
+	if (compileRequested || reloadFence == 0) {
+		return false;
+	}
+
+	GLenum status = glClientWaitSync(reloadFence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED) {
+		return false;
+	}
+	glDeleteSync(reloadFence);
+	reloadFence = 0;
+	valid = reloadValid && status != GL_WAIT_FAILED;
+	set<string> files;
+	files.swap(reloadFiles);
+	guard.unlock();
+
+	watchSources(files);
+	return true;
+}
+
+// Includes added since the last build start being watched; files no longer included stay watched,
+// which costs no more than a spare reload when they change
+void ShaderLibrary::watchSources(const set<string>& files)
+{
+	for (set<string>::const_iterator it = files.begin(); it != files.end(); ++it) {
+		if (sourceFiles.insert(*it).second) {
+			watcher.watch(*it);
+		}
+	}
+}
+
+// Called once per frame, before anything is drawn
+void ShaderLibrary::update()
+{
+	if (reloading.empty()) {
+		vector<string> changed;
+		if (variants.empty() || !watcher.takeChanges(changed, changeTime)) {
+			return;
+		}
+
+		reloadStart = chrono::steady_clock::now();
+		for (map<unsigned int, unique_ptr<Shader>>::iterator it = variants.begin(); it != variants.end(); ++it) {
+			reloading[it->first].reset(new Shader());
+		}
+
+		if (compilerWindow != NULL) {
+			unique_lock<mutex> guard(lock);
+			compileRequested = true;
+			wake.notify_one();
+			return;
+		}
+
+		set<string> files;
+		for (map<unsigned int, unique_ptr<Shader>>::iterator it = reloading.begin(); it != reloading.end(); ++it) {
+			string defines = getDefines(it->first);
+			it->second->compile(preprocess(vertexPath, defines, &files), preprocess(fragmentPath, defines, &files));
+		}
+		watchSources(files);
+	}
+
+	bool valid = true;
+	if (compilerWindow != NULL) {
+		if (!takeReloads(valid)) {
+			return;
+		}
+	}
+	else {
+		// No shared context: without KHR_parallel_shader_compile every variant reports ready and finish() waits for the driver
+		for (map<unsigned int, unique_ptr<Shader>>::iterator it = reloading.begin(); it != reloading.end(); ++it) {
+			if (!it->second->isReady()) {
+				return;
+			}
+		}
+		for (map<unsigned int, unique_ptr<Shader>>::iterator it = reloading.begin(); it != reloading.end(); ++it) {
+			valid = it->second->finish() && valid;
+		}
+	}
+
+	if (valid) {
+		// Swapping the contents keeps the Shader pointers held by the renderer and the curves valid
+		for (map<unsigned int, unique_ptr<Shader>>::iterator it = reloading.begin(); it != reloading.end(); ++it) {
+			swap(*variants[it->first], *it->second);
+		}
+	}
+	else {
+		cout << "ERROR::SHADER::RELOAD_FAILED: keeping the previous programs" << endl;
+	}
+
+	// The losing side of the swap: the old programs, or the broken new ones
+	for (map<unsigned int, unique_ptr<Shader>>::iterator it = reloading.begin(); it != reloading.end(); ++it) {
+		glDeleteProgram(it->second->ID);
+	}
+	reloading.clear();
+
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	if (valid) {
+		cout << "Shaders reloaded: " << chrono::duration<double, milli>(now - changeTime).count() << " ms after the change, "
+			<< chrono::duration<double, milli>(now - reloadStart).count() << " ms compiling" << endl;
+	}
+}
+
+// Summed over the variants, like Shader::getAvoidedLookups for a single program
+int ShaderLibrary::getAvoidedLookups() const
+{
+	int avoidedLookups = 0;
+	for (map<unsigned int, unique_ptr<Shader>>::const_iterator it = variants.begin(); it != variants.end(); ++it) {
+		avoidedLookups += it->second->getAvoidedLookups();
+	}
+	return avoidedLookups;
+}
+
+void ShaderLibrary::resetAvoidedLookups()
+{
+	for (map<unsigned int, unique_ptr<Shader>>::iterator it = variants.begin(); it != variants.end(); ++it) {
+		it->second->resetAvoidedLookups();
+	}
+}
+
+unsigned int ShaderLibrary::getFeatures(const Material& material, bool vertexColor)
+{
+	unsigned int features = vertexColor ? VERTEX_COLOR : 0;
+	if (material.texKd != 0) {
+		features |= TEXTURED;
+	}
+	if (material.ks != glm::vec3(0.0f)) {
+		features |= SPECULAR;
+	}
+	return features;
+}
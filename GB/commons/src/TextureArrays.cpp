@@ -0,0 +1,143 @@
+#include "TextureArrays.h"
+#include "MipChain.h"
+#include "MappedFile.h"
+#include "HashUtils.h"
+
+#include <algorithm>
+#include <iostream>
+
+// Same extension constants as in TextureLoader.cpp
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// Images can only share an array when all of these match
+static unsigned long long getGroupKey(const MipChain& mips)
+{
+	const MipLevel& base = mips.getLevels()[0];
+	return ((unsigned long long)base.width << 40) | ((unsigned long long)base.height << 16)
+		| ((unsigned long long)mips.getFormat() << 8) | mips.getLevels().size();
+}
+
+void TextureArrays::add(const string& path)
+{
+	if (!path.empty() && std::find(paths.begin(), paths.end(), path) == paths.end()) {
+		paths.push_back(path);
+	}
+}
+
+void TextureArrays::build()
+{
+	vector<MipChain> chains(paths.size());
+
+	function<void(int)> decode = [&](int i) {
+		MappedFile file;
+		if (file.open(paths[i])) {
+			unsigned long long hash = hashBytes(file.getData(), file.getSize());
+			size_t fileSize = file.getSize();
+			file.close();
+			chains[i].loadImage(paths[i], hash, fileSize, true, compression);
+		}
+	};
+	if (pool != nullptr) {
+		pool->parallelFor(paths.size(), decode);
+	}
+	else {
+		for (size_t i = 0; i < paths.size(); i++) {
+			decode(i);
+		}
+	}
+
+	vector<size_t> order;
+	for (size_t i = 0; i < chains.size(); i++) {
+		if (chains[i].isEmpty()) {
+			cout << "Failed to load texture: " << paths[i] << endl;
+		}
+		else {
+			order.push_back(i);
+		}
+	}
+	stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return getGroupKey(chains[a]) < getGroupKey(chains[b]); });
+
+	GLint maxLayers = 256;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+	for (size_t first = 0; first < order.size(); ) {
+		// One array per run of matching images, split when the driver's layer limit is reached
+		size_t last = first + 1;
+		while (last < order.size() && (GLint)(last - first) < maxLayers && getGroupKey(chains[order[last]]) == getGroupKey(chains[order[first]])) {
+			last++;
+		}
+		GLsizei nbLayers = last - first;
+
+		const MipChain& reference = chains[order[first]];
+		const vector<MipLevel>& levels = reference.getLevels();
+		GLenum internalFormat = reference.getFormat() == MipChain::BC1 ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+		GLuint array;
+		glGenTextures(1, &array);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+		if (anisotropy > 1.0f) {
+			glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+		}
+
+		// Storage for every layer first, then each image goes into its own layer
+		for (size_t level = 0; level < levels.size(); level++) {
+			const MipLevel& mip = levels[level];
+			if (reference.getFormat() == MipChain::RGBA8) {
+				glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, mip.width, mip.height, nbLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			}
+			else {
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, mip.width, mip.height, nbLayers, 0, mip.data.size() * nbLayers, NULL);
+			}
+
+			for (GLsizei layer = 0; layer < nbLayers; layer++) {
+				const MipLevel& image = chains[order[first + layer]].getLevels()[level];
+				if (reference.getFormat() == MipChain::RGBA8) {
+					glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.width, mip.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, image.data.data());
+				}
+				else {
+					glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.width, mip.height, 1, internalFormat, image.data.size(), image.data.data());
+				}
+			}
+		}
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		arrays.push_back(array);
+		for (GLsizei layer = 0; layer < nbLayers; layer++) {
+			TextureLayer entry;
+			entry.array = array;
+			entry.layer = layer;
+			layers[paths[order[first + layer]]] = entry;
+		}
+
+		first = last;
+	}
+}
+
+void TextureArrays::destroy()
+{
+	if (!arrays.empty()) {
+		glDeleteTextures(arrays.size(), arrays.data());
+	}
+	arrays.clear();
+	layers.clear();
+}
+
+TextureLayer TextureArrays::find(const string& path) const
+{
+	unordered_map<string, TextureLayer>::const_iterator found = layers.find(path);
+	return found != layers.end() ? found->second : TextureLayer();
+}
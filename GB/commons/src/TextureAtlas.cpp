@@ -0,0 +1,301 @@
+#include "TextureAtlas.h"
+#include "ParseUtils.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+struct AtlasImage {
+	string path;
+	int width, height;
+	unsigned char* pixels;
+};
+
+void TextureAtlas::addImage(const string& path)
+{
+	if (find_if(sources.begin(), sources.end(), [&](const string& source) { return source == path; }) == sources.end()) {
+		sources.push_back(path);
+	}
+}
+
+// Collects the diffuse maps of every material in the file
+void TextureAtlas::addMtl(const string& filename)
+{
+	ifstream file(filename);
+
+	if (!file.is_open()) {
+		cout << "Unable to open the file: " << filename << endl;
+		return;
+	}
+
+	string line;
+	while (getline(file, line)) {
+		istringstream row(line);
+		string key;
+
+		if ((row >> key) && key == "map_Kd") {
+			string path = readRest(row);
+			if (!path.empty()) {
+				addImage(path);
+			}
+		}
+	}
+}
+
+// Lowest (then leftmost) spot of the skyline where a width x height rectangle fits
+bool TextureAtlas::findPosition(const vector<SkylineNode>& skyline, int width, int height, int& bestIndex, int& bestX, int& bestY) const
+{
+	bestIndex = -1;
+	bestX = 0;
+	bestY = INT_MAX;
+
+	for (size_t i = 0; i < skyline.size(); i++) {
+		int x = skyline[i].x;
+		if (x + width > pageSize) {
+			break;
+		}
+
+		// The rectangle rests on the highest node it spans
+		int y = 0;
+		int remaining = width;
+		for (size_t j = i; remaining > 0; j++) {
+			y = max(y, skyline[j].y);
+			remaining -= skyline[j].width;
+		}
+
+		if (y + height <= pageSize && (y < bestY || (y == bestY && x < bestX))) {
+			bestIndex = i;
+			bestX = x;
+			bestY = y;
+		}
+	}
+
+	return bestIndex >= 0;
+}
+
+void TextureAtlas::addLevel(vector<SkylineNode>& skyline, int index, int x, int y, int width, int height)
+{
+	SkylineNode node = { x, y + height, width };
+	skyline.insert(skyline.begin() + index, node);
+
+	// Nodes now covered by the new one shrink or disappear
+	for (size_t i = index + 1; i < skyline.size(); ) {
+		int covered = skyline[i - 1].x + skyline[i - 1].width - skyline[i].x;
+		if (covered <= 0) {
+			break;
+		}
+		if (covered >= skyline[i].width) {
+			skyline.erase(skyline.begin() + i);
+			continue;
+		}
+		skyline[i].x += covered;
+		skyline[i].width -= covered;
+		break;
+	}
+
+	// Neighbours at the same height become one node
+	for (size_t i = 0; i + 1 < skyline.size(); ) {
+		if (skyline[i].y == skyline[i + 1].y) {
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+// Uncompressed 32-bit TGA with a top-left origin, readable by stb_image
+bool TextureAtlas::writeTga(const string& filename, const vector<unsigned char>& pixels, int width, int height)
+{
+	ofstream file(filename, ios::binary);
+	if (!file.is_open()) {
+		cout << "Unable to open the file: " << filename << endl;
+		return false;
+	}
+
+	unsigned char header[18] = {};
+	header[2] = 2;
+	header[12] = width & 0xFF;
+	header[13] = (width >> 8) & 0xFF;
+	header[14] = height & 0xFF;
+	header[15] = (height >> 8) & 0xFF;
+	header[16] = 32;
+	header[17] = 0x28;
+	file.write((const char*)header, sizeof(header));
+
+	// TGA stores BGRA
+	vector<unsigned char> row((size_t)width * 4);
+	for (int y = 0; y < height; y++) {
+		const unsigned char* in = pixels.data() + (size_t)y * width * 4;
+		for (int x = 0; x < width; x++) {
+			row[x * 4 + 0] = in[x * 4 + 2];
+			row[x * 4 + 1] = in[x * 4 + 1];
+			row[x * 4 + 2] = in[x * 4 + 0];
+			row[x * 4 + 3] = in[x * 4 + 3];
+		}
+		file.write((const char*)row.data(), row.size());
+	}
+
+	return file.good();
+}
+
+bool TextureAtlas::build(const string& name)
+{
+	vector<AtlasImage> images;
+	for (size_t i = 0; i < sources.size(); i++) {
+		AtlasImage image;
+		image.path = sources[i];
+		image.pixels = stbi_load(image.path.c_str(), &image.width, &image.height, NULL, 4);
+
+		if (image.pixels == NULL) {
+			cout << "Unable to open the file: " << image.path << endl;
+		}
+		else if (image.width + 2 * padding > pageSize || image.height + 2 * padding > pageSize) {
+			cout << "Image larger than an atlas page, left out: " << image.path << endl;
+			stbi_image_free(image.pixels);
+		}
+		else {
+			images.push_back(image);
+		}
+	}
+
+	// Tallest first keeps the skyline flat
+	stable_sort(images.begin(), images.end(), [](const AtlasImage& a, const AtlasImage& b) {
+		return a.height != b.height ? a.height > b.height : a.width > b.width;
+	});
+
+	vector<vector<SkylineNode>> skylines;
+	vector<vector<unsigned char>> pages;
+	vector<long long> usedArea;
+	entries.clear();
+	pageFiles.clear();
+
+	for (size_t i = 0; i < images.size(); i++) {
+		const AtlasImage& image = images[i];
+		int width = image.width + 2 * padding;
+		int height = image.height + 2 * padding;
+
+		int page = 0, index = -1, x = 0, y = 0;
+		for (; page < (int)skylines.size(); page++) {
+			if (findPosition(skylines[page], width, height, index, x, y)) {
+				break;
+			}
+		}
+		if (page == (int)skylines.size()) {
+			SkylineNode ground = { 0, 0, pageSize };
+			skylines.push_back(vector<SkylineNode>(1, ground));
+			pages.push_back(vector<unsigned char>((size_t)pageSize * pageSize * 4, 0));
+			usedArea.push_back(0);
+			findPosition(skylines[page], width, height, index, x, y);
+		}
+		addLevel(skylines[page], index, x, y, width, height);
+		usedArea[page] += (long long)image.width * image.height;
+
+		// The gutter repeats the nearest edge texel
+		unsigned char* out = pages[page].data();
+		for (int py = 0; py < height; py++) {
+			int sy = min(max(py - padding, 0), image.height - 1);
+			for (int px = 0; px < width; px++) {
+				int sx = min(max(px - padding, 0), image.width - 1);
+				memcpy(out + ((size_t)(y + py) * pageSize + x + px) * 4, image.pixels + ((size_t)sy * image.width + sx) * 4, 4);
+			}
+		}
+
+		AtlasEntry entry;
+		entry.page = page;
+		entry.x = x + padding;
+		entry.y = y + padding;
+		entry.width = image.width;
+		entry.height = image.height;
+		entry.uvTransform = glm::vec4((float)entry.width / pageSize, (float)entry.height / pageSize,
+			(float)entry.x / pageSize, (float)entry.y / pageSize);
+		entries[image.path] = entry;
+
+		stbi_image_free(image.pixels);
+	}
+
+	ofstream manifest(name + ".atlas");
+	if (!manifest.is_open()) {
+		cout << "Unable to open the file: " << name << ".atlas" << endl;
+		return false;
+	}
+
+	manifest << "size " << pageSize << endl;
+	bool written = true;
+	for (size_t page = 0; page < pages.size(); page++) {
+		string pageFile = name + "_" + to_string(page) + ".tga";
+		written = writeTga(pageFile, pages[page], pageSize, pageSize) && written;
+		pageFiles.push_back(pageFile);
+		manifest << "page " << pageFile << endl;
+
+		cout << pageFile << ": " << (100.0 * usedArea[page] / ((double)pageSize * pageSize)) << "% of the page used" << endl;
+	}
+	for (map<string, AtlasEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+		const AtlasEntry& entry = it->second;
+		manifest << "image " << entry.page << " " << entry.x << " " << entry.y << " " << entry.width << " " << entry.height << " " << it->first << endl;
+	}
+
+	// Each page replaces the textures packed in it, so a frame drawing all of them binds that many times less
+	cout << entries.size() << " images in " << pages.size() << " page(s), " << (int)(entries.size() - pages.size())
+		<< " texture binds saved per frame" << endl;
+
+	return written;
+}
+
+bool TextureAtlas::load(const string& manifestFilename)
+{
+	ifstream file(manifestFilename);
+
+	if (!file.is_open()) {
+		return false;
+	}
+
+	entries.clear();
+	pageFiles.clear();
+
+	string line;
+	while (getline(file, line)) {
+		istringstream row(line);
+		string key;
+
+		if (!(row >> key)) {
+			continue;
+		}
+
+		if (key == "size") {
+			row >> pageSize;
+		}
+		else if (key == "page") {
+			string pageFile;
+			getline(row >> ws, pageFile);
+			pageFiles.push_back(pageFile);
+		}
+		else if (key == "image") {
+			AtlasEntry entry;
+			string path;
+			row >> entry.page >> entry.x >> entry.y >> entry.width >> entry.height;
+			getline(row >> ws, path);
+			if (entry.page < 0 || entry.page >= (int)pageFiles.size() || pageSize <= 0) {
+				cout << "ERROR::ATLAS::INVALID_ENTRY: " << path << endl;
+				continue;
+			}
+			entry.uvTransform = glm::vec4((float)entry.width / pageSize, (float)entry.height / pageSize,
+				(float)entry.x / pageSize, (float)entry.y / pageSize);
+			entries[path] = entry;
+		}
+	}
+
+	return true;
+}
+
+// Looks an image up by the path written in the MTL file
+const AtlasEntry* TextureAtlas::find(const string& path) const
+{
+	map<string, AtlasEntry>::const_iterator found = entries.find(path);
+	return found != entries.end() ? &found->second : NULL;
+}
@@ -0,0 +1,320 @@
+#include "TextureLoader.h"
+#include "MappedFile.h"
+#include "HashUtils.h"
+
+#include <climits>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+
+// Core only since GL 4.6, otherwise EXT/ARB_texture_filter_anisotropic with the same values
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+// EXT_texture_compression_s3tc, not part of the core profile GLAD was generated for
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// Absolute path with "." and ".." resolved, so different spellings of the same file share a cache entry
+static string getCanonicalPath(const string& path)
+{
+#ifdef _WIN32
+	char resolved[_MAX_PATH];
+	if (_fullpath(resolved, path.c_str(), _MAX_PATH) != NULL) {
+		return resolved;
+	}
+#else
+	char resolved[PATH_MAX];
+	if (realpath(path.c_str(), resolved) != NULL) {
+		return resolved;
+	}
+#endif
+	return path;
+}
+
+TextureLoader::~TextureLoader()
+{
+	// Decode tasks point to this loader, so they must be finished before it goes away
+	unique_lock<mutex> guard(lock);
+	decodeDone.wait(guard, [this] { return nbDecoding == 0; });
+
+}
+
+GLuint TextureLoader::load(const string& path)
+{
+	string canonicalPath = getCanonicalPath(path);
+
+	unordered_map<string, GLuint>::iterator byPath = texturesByPath.find(canonicalPath);
+	if (byPath != texturesByPath.end()) {
+		cache[byPath->second].refCount++;
+		nbHits++;
+		return byPath->second;
+	}
+
+	// Hashing the mapped file is far cheaper than decoding it, and catches copies of the same image
+	CachedTexture entry = { 1, canonicalPath, 0, 0, 4 };
+	MappedFile file;
+	if (file.open(canonicalPath)) {
+		entry.hash = hashBytes(file.getData(), file.getSize());
+		entry.fileSize = file.getSize();
+		file.close();
+
+		unordered_map<unsigned long long, GLuint>::iterator byHash = texturesByHash.find(entry.hash);
+		if (byHash != texturesByHash.end() && cache[byHash->second].fileSize == entry.fileSize) {
+			cache[byHash->second].refCount++;
+			texturesByPath[canonicalPath] = byHash->second;
+			nbHits++;
+			return byHash->second;
+		}
+	}
+
+	GLuint tex = createTexture(canonicalPath, entry.hash, entry.fileSize);
+
+	cache[tex] = entry;
+	texturesByPath[canonicalPath] = tex;
+	if (entry.fileSize > 0) {
+		texturesByHash[entry.hash] = tex;
+	}
+	residentBytes += entry.bytes;
+	nbMisses++;
+
+	return tex;
+}
+
+void TextureLoader::release(GLuint texture)
+{
+	unordered_map<GLuint, CachedTexture>::iterator found = cache.find(texture);
+	if (found == cache.end() || --found->second.refCount > 0) {
+		return;
+	}
+
+	for (unordered_map<string, GLuint>::iterator it = texturesByPath.begin(); it != texturesByPath.end();) {
+		it = it->second == texture ? texturesByPath.erase(it) : next(it);
+	}
+
+	unordered_map<unsigned long long, GLuint>::iterator byHash = texturesByHash.find(found->second.hash);
+	if (byHash != texturesByHash.end() && byHash->second == texture) {
+		texturesByHash.erase(byHash);
+	}
+
+	residentBytes -= found->second.bytes;
+	cache.erase(found);
+
+	glDeleteTextures(1, &texture);
+}
+
+GLuint TextureLoader::createTexture(const string& path, unsigned long long hash, size_t fileSize)
+{
+	GLuint tex;
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	queryDriverSupport();
+	if (anisotropy > 1.0f) {
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+	}
+
+	// Neutral grey until the image is ready, and for good if it fails to load. With a single level
+	// the texture is complete under the mipmap filter; update() raises the limit with the chain.
+	const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	nbPending++;
+
+	{
+		unique_lock<mutex> guard(lock);
+		nbDecoding++;
+	}
+
+	bool compressed = compression && s3tcSupported;
+	if (pool != nullptr) {
+		pool->enqueue([this, tex, path, hash, fileSize, compressed] { decode(tex, path, hash, fileSize, compressed); });
+	}
+	else {
+		decode(tex, path, hash, fileSize, compressed);
+	}
+
+	return tex;
+}
+
+void TextureLoader::queryDriverSupport()
+{
+	if (driverQueried) {
+		return;
+	}
+	driverQueried = true;
+
+	GLint nbExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &nbExtensions);
+	for (GLint i = 0; i < nbExtensions; i++) {
+		string extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension == "GL_EXT_texture_filter_anisotropic" || extension == "GL_ARB_texture_filter_anisotropic") {
+			GLfloat supported = 1.0f;
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &supported);
+			anisotropy = min(maxAnisotropy, supported);
+		}
+		else if (extension == "GL_EXT_texture_compression_s3tc") {
+			s3tcSupported = true;
+		}
+	}
+}
+
+void TextureLoader::decode(GLuint texture, const string& path, unsigned long long hash, size_t fileSize, bool compressed)
+{
+	DecodedImage image;
+	image.texture = texture;
+	image.path = path;
+	image.mips.loadImage(path, hash, fileSize, true, compressed);
+
+	unique_lock<mutex> guard(lock);
+	decoded.push_back(move(image));
+	nbDecoding--;
+	decodeDone.notify_all();
+}
+
+// Checks a chain taken from the queue and binds its texture; false when there is nothing to upload
+bool TextureLoader::startUpload(DecodedImage& image)
+{
+	// Released while it was being decoded (the GL name may even have been reused since)
+	unordered_map<GLuint, CachedTexture>::iterator entry = cache.find(image.texture);
+	if (entry == cache.end() || entry->second.path != image.path) {
+		return false;
+	}
+
+	// The placeholder stays, still complete with its single level
+	if (image.mips.isEmpty()) {
+		cout << "Failed to load texture: " << image.path << endl;
+		return false;
+	}
+
+	image.level = image.mips.getLevels().size() - 1;
+	image.nextRow = 0;
+	return true;
+}
+
+// Sends rows of the current level, as many as fit in budget (at least one when first is set, so
+// any row size gets through), and moves to the next level once this one is complete. Returns the
+// bytes sent, 0 when not even one row fits.
+size_t TextureLoader::uploadRows(DecodedImage& image, size_t budget, bool first)
+{
+	const MipLevel& mip = image.mips.getLevels()[image.level];
+	unsigned int format = image.mips.getFormat();
+	GLenum internalFormat = format == MipChain::BC1 ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+	// Compressed levels are cut between rows of 4x4 blocks
+	int rowHeight = format == MipChain::RGBA8 ? 1 : 4;
+	int nbRows = (mip.height + rowHeight - 1) / rowHeight;
+	size_t rowBytes = mip.data.size() / nbRows;
+	int count = (int)min((size_t)(nbRows - image.nextRow), budget / rowBytes);
+	if (count == 0) {
+		if (!first) {
+			return 0;
+		}
+		count = 1;
+	}
+
+	int y = image.nextRow * rowHeight;
+	int height = min((image.nextRow + count) * rowHeight, mip.height) - y;
+	const unsigned char* data = mip.data.data() + image.nextRow * rowBytes;
+	size_t size = count * rowBytes;
+
+	// The whole chain comes from the CPU, so there is no glGenerateMipmap stall here
+	glBindTexture(GL_TEXTURE_2D, image.texture);
+	if (count == nbRows) {
+		if (format == MipChain::RGBA8) {
+			glTexImage2D(GL_TEXTURE_2D, image.level, GL_RGBA8, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
+		else {
+			glCompressedTexImage2D(GL_TEXTURE_2D, image.level, internalFormat, mip.width, mip.height, 0, size, data);
+		}
+	}
+	else {
+		// Storage first, then the bands; the level is below the base level until its last band is in
+		if (image.nextRow == 0) {
+			if (format == MipChain::RGBA8) {
+				glTexImage2D(GL_TEXTURE_2D, image.level, GL_RGBA8, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			}
+			else {
+				glCompressedTexImage2D(GL_TEXTURE_2D, image.level, internalFormat, mip.width, mip.height, 0, mip.data.size(), NULL);
+			}
+		}
+		if (format == MipChain::RGBA8) {
+			glTexSubImage2D(GL_TEXTURE_2D, image.level, 0, y, mip.width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
+		else {
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, image.level, 0, y, mip.width, height, internalFormat, size, data);
+		}
+	}
+	image.nextRow += count;
+
+	if (image.nextRow == nbRows) {
+		// Levels base..max are all complete: the new one becomes the sharpest sampled
+		int nbLevels = image.mips.getLevels().size();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, nbLevels - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, image.level);
+		image.level--;
+		image.nextRow = 0;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return size;
+}
+
+void TextureLoader::update()
+{
+	size_t uploaded = 0;
+
+	while (uploaded < uploadBudget) {
+		if (!isUploading) {
+			{
+				unique_lock<mutex> guard(lock);
+				if (decoded.empty()) {
+					return;
+				}
+				uploading = move(decoded.front());
+				decoded.pop_front();
+			}
+			isUploading = startUpload(uploading);
+			if (!isUploading) {
+				nbPending--;
+			}
+			continue;
+		}
+
+		// Released between two frames of its upload
+		unordered_map<GLuint, CachedTexture>::iterator entry = cache.find(uploading.texture);
+		if (entry == cache.end() || entry->second.path != uploading.path) {
+			isUploading = false;
+			nbPending--;
+			continue;
+		}
+
+		size_t sent = uploadRows(uploading, uploadBudget - uploaded, uploaded == 0);
+		if (sent == 0) {
+			return;
+		}
+		uploaded += sent;
+
+		if (uploading.level < 0) {
+			residentBytes += uploading.mips.getSize() - entry->second.bytes;
+			entry->second.bytes = uploading.mips.getSize();
+			uploading.mips = MipChain();
+			isUploading = false;
+			nbPending--;
+		}
+	}
+}
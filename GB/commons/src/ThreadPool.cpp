@@ -0,0 +1,116 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int nbThreads)
+{
+	if (nbThreads <= 0) {
+		nbThreads = thread::hardware_concurrency();
+	}
+
+	// The caller of parallelFor() works as well, so one thread less is spawned
+	for (int i = 1; i < nbThreads; i++) {
+		workers.push_back(thread(&ThreadPool::workerLoop, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+	wakeWorkers.notify_all();
+
+	for (thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::parallelFor(int count, const function<void(int)>& task)
+{
+	if (count <= 0) {
+		return;
+	}
+
+	if (workers.empty() || count == 1) {
+		for (int i = 0; i < count; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	Job job;
+	job.task = &task;
+	job.nextTask = 0;
+	job.nbTasks = count;
+	job.nbPending = count;
+
+	unique_lock<mutex> guard(lock);
+	jobs.push_back(&job);
+	wakeWorkers.notify_all();
+
+	while (runNextTask(job, guard)) {
+	}
+
+	jobDone.wait(guard, [&job] { return job.nbPending == 0; });
+}
+
+void ThreadPool::enqueue(const function<void()>& task)
+{
+	if (workers.empty()) {
+		task();
+		return;
+	}
+
+	{
+		unique_lock<mutex> guard(lock);
+		backgroundTasks.push_back(task);
+	}
+	wakeWorkers.notify_one();
+}
+
+bool ThreadPool::runNextTask(Job& job, unique_lock<mutex>& guard)
+{
+	if (job.nextTask >= job.nbTasks) {
+		return false;
+	}
+
+	int index = job.nextTask++;
+	// Fully handed out: the caller still waits for the running tasks, but workers look elsewhere
+	if (job.nextTask == job.nbTasks) {
+		jobs.erase(find(jobs.begin(), jobs.end(), &job));
+	}
+
+	guard.unlock();
+	(*job.task)(index);
+	guard.lock();
+
+	if (--job.nbPending == 0) {
+		jobDone.notify_all();
+	}
+
+	return true;
+}
+
+void ThreadPool::workerLoop()
+{
+	unique_lock<mutex> guard(lock);
+
+	while (true) {
+		wakeWorkers.wait(guard, [this] { return stopping || !jobs.empty() || !backgroundTasks.empty(); });
+
+		if (stopping) {
+			return;
+		}
+
+		if (jobs.empty() || !runNextTask(*jobs.front(), guard)) {
+			function<void()> task = backgroundTasks.front();
+			backgroundTasks.pop_front();
+
+			guard.unlock();
+			task();
+			guard.lock();
+		}
+	}
+}
@@ -0,0 +1,32 @@
+// Blocks shared by shaders.vs and shaders.fs, see FrameUniforms and MaterialUniforms in Renderer.h.
+// NUM_LIGHTS (set by ShaderLibrary) is how many of the MAX_LIGHTS slots are lit.
+
+#define MAX_LIGHTS 4
+
+#ifndef NUM_LIGHTS
+#define NUM_LIGHTS 1
+#endif
+
+// Per-frame data shared by every draw
+layout (std140, binding = 0) uniform FrameData
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPos;
+    vec4 lightPos[MAX_LIGHTS];
+    vec4 lightColor[MAX_LIGHTS];
+};
+
+// Range of the shared material buffer bound for this draw
+layout (std140, binding = 1) uniform MaterialData
+{
+    vec4 ka;
+    vec4 kd;
+    vec4 ks;
+    float q;
+    float ni;
+    float d;
+    // Layer in tex_array, or -1 when the material samples tex_buffer
+    int layer;
+    vec4 uvTransform;
+};
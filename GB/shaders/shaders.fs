@@ -1,44 +1,58 @@
 #version 450
 
+#include "common.glsl"
+
+#ifdef VERTEX_COLOR
 in vec3 finalColor;
+#endif
 in vec3 scaledNormal;
 in vec2 texCoord;
 in vec3 fragPos;
 
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-
-uniform float ka;
-uniform float kd;
-uniform float ks;
-uniform float q;
-
-uniform vec3 cameraPos;
-
-uniform sampler2D tex_buffer;
+#ifdef TEXTURED
+// Fixed units, see Renderer::ARRAY_TEXTURE_UNIT
+layout (binding = 0) uniform sampler2D tex_buffer;
+layout (binding = 1) uniform sampler2DArray tex_array;
+#endif
 
 out vec4 color;
 
 void main()
 {
-	vec3 ambient = ka * lightColor;
-
-	//Cálculo da parcela de iluminação difusa
 	vec3 N = normalize(scaledNormal);
-	vec3 L = normalize(lightPos - fragPos);
-	float diff = max(dot(N,L),0.0);
-	vec3 diffuse = kd * diff * lightColor;
-
-	//Cálculo da parcela de iluminação especular
-	vec3 V = normalize(cameraPos - fragPos);
-	vec3 R = normalize(reflect(-L,N));
-	float spec = max(dot(R,V),0.0);
-	spec = pow(spec,q);
-	vec3 specular = ks * spec * lightColor;
-
-	vec3 texColor = texture(tex_buffer, texCoord).xyz;
-
-	vec3 result = (ambient + diffuse) * texColor + specular;
+	vec3 V = normalize(cameraPos.xyz - fragPos);
+
+	vec3 ambient = vec3(0.0);
+	vec3 diffuse = vec3(0.0);
+	vec3 specular = vec3(0.0);
+
+	for (int i = 0; i < NUM_LIGHTS; i++) {
+		ambient += ka.xyz * lightColor[i].xyz;
+
+		//Cálculo da parcela de iluminação difusa
+		vec3 L = normalize(lightPos[i].xyz - fragPos);
+		float diff = max(dot(N,L),0.0);
+		diffuse += kd.xyz * diff * lightColor[i].xyz;
+
+#ifdef SPECULAR
+		//Cálculo da parcela de iluminação especular
+		vec3 R = normalize(reflect(-L,N));
+		float spec = max(dot(R,V),0.0);
+		spec = pow(spec,q);
+		specular += ks.xyz * spec * lightColor[i].xyz;
+#endif
+	}
+
+	vec3 surfaceColor = vec3(1.0);
+#ifdef TEXTURED
+	// layer is the same for the whole draw, so every fragment takes the same branch
+	surfaceColor = layer >= 0 ? texture(tex_array, vec3(texCoord, layer)).xyz : texture(tex_buffer, texCoord).xyz;
+#endif
+#ifdef VERTEX_COLOR
+	surfaceColor *= finalColor;
+#endif
+
+	vec3 result = (ambient + diffuse) * surfaceColor + specular;
 
 	color = vec4(result,1.0);
 }
\ No newline at end of file
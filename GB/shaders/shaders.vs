@@ -1,24 +1,44 @@
 #version 450
 
+#include "common.glsl"
+
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 color;
 layout (location = 2) in vec2 tex_coord;
-layout (location = 3) in vec3 normal;
+// Octahedral-encoded normal, see Mesh::pack
+layout (location = 3) in vec2 packedNormal;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
+#ifdef VERTEX_COLOR
 out vec3 finalColor;
+#endif
 out vec2 texCoord;
 out vec3 fragPos;
 out vec3 scaledNormal;
 
+vec2 signNotZero(vec2 v)
+{
+    return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec3 decodeNormal(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * signNotZero(n.xy);
+    }
+    return normalize(n);
+}
+
 void main()
 {
     gl_Position = projection * view * model * vec4(position, 1.0);
+#ifdef VERTEX_COLOR
     finalColor = color;
-    texCoord = vec2(tex_coord.x, 1 - tex_coord.y);
-    scaledNormal = normal;
+#endif
+    // Moves the UVs into the material's atlas region, identity when the texture is not atlased
+    texCoord = vec2(tex_coord.x, 1 - tex_coord.y) * uvTransform.xy + uvTransform.zw;
+    scaledNormal = decodeNormal(packedNormal);
     fragPos = vec3(model * vec4(position, 1.0));
 }
\ No newline at end of file
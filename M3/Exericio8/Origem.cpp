@@ -12,6 +12,7 @@
 #include <assert.h>
 #include <fstream>
 #include <sstream>
+#include <map>
 
 using namespace std;
 
@@ -197,12 +198,12 @@ int main()
 		glBindTexture(GL_TEXTURE_2D, texID);
 
 		glBindVertexArray(VAO);
-		glDrawArraysInstanced(GL_TRIANGLES, 0, 36, 1);
+		glDrawElementsInstanced(GL_TRIANGLES, nVerts, GL_UNSIGNED_INT, 0, 1);
 
 		// Chamada de desenho - drawcall
 		// CONTORNO - GL_LINE_LOOP
 		
-		glDrawArrays(GL_POINTS, 0, 36);
+		glDrawElements(GL_POINTS, nVerts, GL_UNSIGNED_INT, 0);
 		glBindVertexArray(0);
 
 		// Troca os buffers da tela
@@ -327,6 +328,8 @@ int loadSimpleOBJ(string filepath, int& nVerts, glm::vec3 color)
 	vector <glm::vec2> texCoords;
 	vector <glm::vec3> normals;
 	vector <GLfloat> vbuffer;
+	// Cada tripla v/vt/vn distinta vira um único vértice no vbuffer
+	map <string, GLuint> uniqueVertices;
 
 	// Leitura do arquivo
 
@@ -381,11 +384,21 @@ int loadSimpleOBJ(string filepath, int& nVerts, glm::vec3 color)
 
 				for (int i = 0; i < 3; i++)
 				{
+					//Reaproveitando o vértice caso a tripla já tenha aparecido em outra face
+					map <string, GLuint>::iterator found = uniqueVertices.find(tokens[i]);
+					if (found != uniqueVertices.end())
+					{
+						indices.push_back(found->second);
+						continue;
+					}
+					GLuint newIndex = vbuffer.size() / 11;
+					uniqueVertices[tokens[i]] = newIndex;
+					indices.push_back(newIndex);
+
 					//Recuperando os indices de v
 					int pos = tokens[i].find("/");
 					string token = tokens[i].substr(0, pos);
 					int index = atoi(token.c_str()) - 1;
-					indices.push_back(index);
 
 					vbuffer.push_back(vertices[index].x);
 					vbuffer.push_back(vertices[index].y);
@@ -418,8 +431,8 @@ int loadSimpleOBJ(string filepath, int& nVerts, glm::vec3 color)
 		cout << "Problema ao encontrar o arquivo " << filepath << endl;
 	}
 	inputFile.close();
-	GLuint VBO, VAO;
-	nVerts = vbuffer.size() / 11; // 3 pos + 3 cor + 3 normal + 2 texcoord
+	GLuint VBO, VAO, EBO;
+	nVerts = indices.size(); // 3 índices por triângulo, cada vértice com 3 pos + 3 cor + 3 normal + 2 texcoord
 	//Geração do identificador do VBO
 	glGenBuffers(1, &VBO);
 	//Faz a conexão (vincula) do buffer como um buffer de array
@@ -451,6 +464,11 @@ int loadSimpleOBJ(string filepath, int& nVerts, glm::vec3 color)
 	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(3);
 
+	//Geração do EBO com os índices dos vértices únicos (o vínculo fica registrado no VAO)
+	glGenBuffers(1, &EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
 	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice 
 	// atualmente vinculado - para que depois possamos desvincular com segurança
 	glBindBuffer(GL_ARRAY_BUFFER, 0);